@@ -0,0 +1,25 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    tictactoe \
+    engine \
+    server \
+    regression \
+    benchmark \
+    tournament \
+    stats \
+    selfplay \
+    train \
+    solve
+
+tictactoe.depends = core
+engine.depends = core
+server.depends = core
+regression.depends = core
+benchmark.depends = core
+tournament.depends = core
+stats.depends = core
+selfplay.depends = core
+train.depends = core
+solve.depends = core
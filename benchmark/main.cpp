@@ -0,0 +1,395 @@
+// Times the engine primitives on every grid size from 3 to 7.
+//
+//  tictactoe-benchmark [--format text|csv|json] [--repetitions <n>] [--filter <name>]
+//
+// Each benchmark is warmed up first, which also sizes its batch so one sample
+// takes about SampleTargetUs, then timed over the given number of samples
+// (default 30). Results are nanoseconds per call: min, median, mean, standard
+// deviation and 90th percentile over the samples.
+
+#include "game.h"
+#include "patterneval.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum
+{
+    MinGridSize = 3,
+    MaxGridSize = 7,
+    WarmupSamples = 5,
+    SampleTargetUs = 200,
+    DefaultRepetitions = 30,
+    PositionCount = 64,
+};
+
+struct GameBenchmark
+{
+    static bool IsOver(const Game& game, Game::Position last)
+    {
+        Game::PlayerEntity winner;
+        return game.ComputeIsOver(last, game.mMoves, winner);
+    }
+
+    static Game::Position RandomMove(Game& game) {return game.ComputeRandomMove();}
+
+    // the empty cells in the order the search visits them
+    static int GenerateMoves(const Game& game, int* cells)
+    {
+        int count = 0;
+        int gridSize = game.GetGridSize();
+        for (int i = 0; i < gridSize; i++)
+            for (int j = 0; j < gridSize; j++)
+                if (game.mGrid[i][j] == Game::PlayerEntity::None)
+                    cells[count++] = i * gridSize + j;
+        return count;
+    }
+
+    static uint64_t Hash(const Game& game)
+    {
+        uint64_t hash = 0;
+        int gridSize = game.GetGridSize();
+        for (int i = 0; i < gridSize; i++)
+            for (int j = 0; j < gridSize; j++)
+                if (game.mGrid[i][j] != Game::PlayerEntity::None)
+                    hash ^= Game::CellKey(i * gridSize + j, game.mGrid[i][j]);
+        return hash;
+    }
+};
+
+struct Result
+{
+    std::string mName;
+    int mGridSize;
+    long long mBatch;
+    double mMin;
+    double mMedian;
+    double mMean;
+    double mStdDev;
+    double mP90;
+};
+
+// keeps the optimiser from dropping the measured work
+static volatile uint64_t sSink;
+
+// a position halfway through a random game that is not over yet, with the move that led to it
+struct Sample
+{
+    Game mGame;
+    Game::Position mLast;
+    Game::Position mNext;
+};
+
+static std::vector<Sample> MakeSamples(int gridSize)
+{
+    std::vector<Sample> samples;
+    Random random(gridSize);
+    while (samples.size() < PositionCount)
+    {
+        Game game(Game::Level::Random, false, gridSize);
+        game.SetSeed(random.Generate());
+        Game::Position last;
+        for (int k = 0; k < gridSize * gridSize / 2 && game.GetPlayerAtMove() != Game::PlayerEntity::None; k++)
+        {
+            last = GameBenchmark::RandomMove(game);
+            game.SetMove(last);
+        }
+
+        if (game.GetPlayerAtMove() == Game::PlayerEntity::None)
+            continue;
+
+        Game copy = game;
+        Game::Position next = GameBenchmark::RandomMove(copy);
+        samples.push_back({game, last, next});
+    }
+    return samples;
+}
+
+// prepare runs untimed before each sample and gets the batch size, body runs batch times
+static Result Run(const std::string& name, int gridSize, int repetitions,
+                  const std::function<void(long long)>& prepare, const std::function<void(long long)>& body)
+{
+    using Clock = std::chrono::steady_clock;
+    auto time = [&](long long batch)
+    {
+        prepare(batch);
+        auto start = Clock::now();
+        body(batch);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+
+    long long batch = 1;
+    for (int k = 0; k < WarmupSamples; k++)
+        while (time(batch) < SampleTargetUs * 1000.0 && batch < (1LL << 30))
+            batch *= 2;
+
+    std::vector<double> samples;
+    for (int k = 0; k < repetitions; k++)
+        samples.push_back(time(batch) / batch);
+
+    std::sort(samples.begin(), samples.end());
+    double mean = 0;
+    for (double sample : samples)
+        mean += sample;
+    mean /= samples.size();
+
+    double variance = 0;
+    for (double sample : samples)
+        variance += (sample - mean) * (sample - mean);
+
+    Result result;
+    result.mName = name;
+    result.mGridSize = gridSize;
+    result.mBatch = batch;
+    result.mMin = samples.front();
+    result.mMedian = samples[samples.size() / 2];
+    result.mMean = mean;
+    result.mStdDev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+    result.mP90 = samples[(samples.size() - 1) * 9 / 10];
+    return result;
+}
+
+static std::vector<Result> RunAll(int gridSize, int repetitions, const std::string& filter)
+{
+    std::vector<Result> results;
+    std::vector<Sample> samples = MakeSamples(gridSize);
+    std::vector<Game> games;
+    std::vector<PositionCode> codes;
+    for (auto& sample : samples)
+        codes.push_back(sample.mGame.GetPositionCode());
+    auto noPrepare = [](long long) {};
+    auto add = [&](const std::string& name, const std::function<void(long long)>& prepare, const std::function<void(long long)>& body)
+    {
+        if (filter.empty() || name.find(filter) != std::string::npos)
+            results.push_back(Run(name, gridSize, repetitions, prepare, body));
+    };
+
+    // SetMove changes the game, every call gets its own fresh copy
+    add("SetMove", [&](long long batch)
+    {
+        games.clear();
+        for (long long k = 0; k < batch; k++)
+            games.push_back(samples[k % PositionCount].mGame);
+    }, [&](long long batch)
+    {
+        for (long long k = 0; k < batch; k++)
+            games[k].SetMove(samples[k % PositionCount].mNext);
+        sSink = sSink + static_cast<int>(games[0].GetPlayerAtMove());
+    });
+
+    add("UndoMove", [&](long long batch)
+    {
+        games.clear();
+        for (long long k = 0; k < batch; k++)
+            games.push_back(samples[k % PositionCount].mGame);
+    }, [&](long long batch)
+    {
+        for (long long k = 0; k < batch; k++)
+            games[k].UndoMove();
+        sSink = sSink + static_cast<int>(games[0].GetPlayerAtMove());
+    });
+
+    add("ComputeIsOver", noPrepare, [&](long long batch)
+    {
+        uint64_t over = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            const Sample& sample = samples[k % PositionCount];
+            over += GameBenchmark::IsOver(sample.mGame, sample.mLast);
+        }
+        sSink = sSink + over;
+    });
+
+    add("GenerateMoves", noPrepare, [&](long long batch)
+    {
+        int cells[Geometry::MaxCells];
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+            total += GameBenchmark::GenerateMoves(samples[k % PositionCount].mGame, cells);
+        sSink = sSink + total;
+    });
+
+    add("ComputeRandomMove", [&](long long)
+    {
+        games.clear();
+        for (auto& sample : samples)
+            games.push_back(sample.mGame);
+    }, [&](long long batch)
+    {
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+            total += GameBenchmark::RandomMove(games[k % PositionCount]).mX;
+        sSink = sSink + total;
+    });
+
+    add("GetUiSign", noPrepare, [&](long long batch)
+    {
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            const Sample& sample = samples[k % PositionCount];
+            total += static_cast<int>(sample.mGame.GetUiSign(sample.mLast));
+        }
+        sSink = sSink + total;
+    });
+
+    add("CopyGame", noPrepare, [&](long long batch)
+    {
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            Game copy = samples[k % PositionCount].mGame;
+            total += copy.GetGridSize();
+        }
+        sSink = sSink + total;
+    });
+
+    // a round trip each, writing into a stack buffer and parsing it back
+    add("PositionCodeText", noPrepare, [&](long long batch)
+    {
+        char text[PositionCode::MaxTextSize];
+        PositionCode code;
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            int length = codes[k % PositionCount].WriteText(text);
+            total += code.ParseText(text, length);
+        }
+        sSink = sSink + total + code.mCells[0];
+    });
+
+    add("PositionCodeBinary", noPrepare, [&](long long batch)
+    {
+        uint8_t data[PositionCode::MaxBinarySize];
+        PositionCode code;
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            int size = codes[k % PositionCount].WriteBinary(data);
+            total += code.ReadBinary(data, size);
+        }
+        sSink = sSink + total + code.mCells[0];
+    });
+
+    add("GameFromCode", noPrepare, [&](long long batch)
+    {
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+        {
+            Game game(codes[k % PositionCount]);
+            total += static_cast<int>(game.GetPlayerAtMove());
+        }
+        sSink = sSink + total;
+    });
+
+    // indexes from scratch as the trainer computes them, and the weight lookups
+    // alone as Game does with its incrementally updated indexes
+    add("PatternIndexes", noPrepare, [&](long long batch)
+    {
+        int32_t indexes[PatternEval::MaxTuples];
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+            total += PatternEval::GetIndexes(codes[k % PositionCount], indexes) + indexes[0];
+        sSink = sSink + total;
+    });
+
+    PatternEval eval;
+    eval.ResetWeights(gridSize);
+    std::vector<int32_t> patternIndexes(PositionCount * PatternEval::MaxTuples);
+    int tupleCount = 0;
+    for (int k = 0; k < PositionCount; k++)
+        tupleCount = PatternEval::GetIndexes(codes[k], &patternIndexes[k * PatternEval::MaxTuples]);
+    add("PatternSum", noPrepare, [&](long long batch)
+    {
+        float total = 0.0f;
+        for (long long k = 0; k < batch; k++)
+            total += PatternEval::Sum(eval.GetWeights(gridSize), &patternIndexes[(k % PositionCount) * PatternEval::MaxTuples],
+                                      tupleCount);
+        sSink = sSink + static_cast<uint64_t>(total);
+    });
+
+    add("Hash", noPrepare, [&](long long batch)
+    {
+        uint64_t total = 0;
+        for (long long k = 0; k < batch; k++)
+            total ^= GameBenchmark::Hash(samples[k % PositionCount].mGame);
+        sSink = sSink + total;
+    });
+
+    return results;
+}
+
+static void Print(const std::vector<Result>& results, const std::string& format)
+{
+    std::cout << std::fixed << std::setprecision(2);
+    if (format == "csv")
+    {
+        std::cout << "name,size,batch,min_ns,median_ns,mean_ns,stddev_ns,p90_ns\n";
+        for (auto& r : results)
+            std::cout << r.mName << ',' << r.mGridSize << ',' << r.mBatch << ',' << r.mMin << ',' << r.mMedian << ','
+                      << r.mMean << ',' << r.mStdDev << ',' << r.mP90 << '\n';
+    }
+    else if (format == "json")
+    {
+        std::cout << "[\n";
+        for (size_t k = 0; k < results.size(); k++)
+        {
+            auto& r = results[k];
+            std::cout << "  {\"name\": \"" << r.mName << "\", \"size\": " << r.mGridSize << ", \"batch\": " << r.mBatch
+                      << ", \"min_ns\": " << r.mMin << ", \"median_ns\": " << r.mMedian << ", \"mean_ns\": " << r.mMean
+                      << ", \"stddev_ns\": " << r.mStdDev << ", \"p90_ns\": " << r.mP90 << '}'
+                      << (k + 1 < results.size() ? "," : "") << '\n';
+        }
+        std::cout << "]\n";
+    }
+    else
+    {
+        std::cout << std::left << std::setw(20) << "benchmark" << std::right << std::setw(5) << "size"
+                  << std::setw(12) << "min ns" << std::setw(12) << "median ns" << std::setw(12) << "mean ns"
+                  << std::setw(12) << "stddev" << std::setw(12) << "p90 ns" << '\n';
+        for (auto& r : results)
+            std::cout << std::left << std::setw(20) << r.mName << std::right << std::setw(5) << r.mGridSize
+                      << std::setw(12) << r.mMin << std::setw(12) << r.mMedian << std::setw(12) << r.mMean
+                      << std::setw(12) << r.mStdDev << std::setw(12) << r.mP90 << '\n';
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string format = "text";
+    std::string filter;
+    int repetitions = DefaultRepetitions;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+            format = argv[++i];
+        else if (arg == "--repetitions" && i + 1 < argc)
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            std::cerr << "usage: tictactoe-benchmark [--format text|csv|json] [--repetitions <n>] [--filter <name>]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    for (int gridSize = MinGridSize; gridSize <= MaxGridSize; gridSize++)
+    {
+        std::vector<Result> size = RunAll(gridSize, repetitions, filter);
+        results.insert(results.end(), size.begin(), size.end());
+    }
+
+    Print(results, format);
+    return 0;
+}
@@ -0,0 +1,14 @@
+# Included by the projects linking the engine core library.
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+trace: DEFINES += TICTACTOE_TRACE
+
+win32:CONFIG(release, debug|release): CORE_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): CORE_DIR = $$OUT_PWD/../core/debug
+else: CORE_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$CORE_DIR -ltictactoe-core
+win32-g++: PRE_TARGETDEPS += $$CORE_DIR/libtictactoe-core.a
+else:win32: PRE_TARGETDEPS += $$CORE_DIR/tictactoe-core.lib
+else: PRE_TARGETDEPS += $$CORE_DIR/libtictactoe-core.a
@@ -0,0 +1,35 @@
+# Engine core as a static library without Qt, shared by the GUI and the tools.
+TEMPLATE = lib
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+TARGET = tictactoe-core
+
+# qmake CONFIG+=trace compiles in the Chrome trace markers
+trace: DEFINES += TICTACTOE_TRACE
+# qmake CONFIG+=avx2 gathers the pattern evaluation weights eight at a time
+avx2: QMAKE_CXXFLAGS += -mavx2
+
+SOURCES += \
+    engineconfig.cpp \
+    game.cpp \
+    mappedfile.cpp \
+    patterneval.cpp \
+    positioncode.cpp \
+    positionstats.cpp \
+    proofsearch.cpp \
+    searchcache.cpp \
+    trace.cpp
+
+HEADERS += \
+    engineconfig.h \
+    game.h \
+    geometry.h \
+    mappedfile.h \
+    patterneval.h \
+    positioncode.h \
+    positionstats.h \
+    proofsearch.h \
+    random.h \
+    searchcache.h \
+    trace.h
@@ -0,0 +1,68 @@
+#include "engineconfig.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+bool EngineConfig::Parse(const std::string& text)
+{
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos)
+            return false;
+
+        std::string key = item.substr(0, equals);
+        if (key == "stats" || key == "eval")
+        {
+            (key == "stats" ? mStatsPath : mEvalPath) = item.substr(equals + 1);
+            continue;
+        }
+
+        long long value = std::atoll(item.c_str() + equals + 1);
+        if (key == "level")
+            mLevel = static_cast<Game::Level>(std::max(0LL, std::min(value, static_cast<long long>(Game::Level::Max))));
+        else if (key == "nodes")
+            mNodes = std::max(0LL, value);
+        else if (key == "movetime")
+            mMoveTime = static_cast<int>(std::max(1LL, value));
+        else if (key == "endgame")
+            mEndgameEmpties = static_cast<int>(std::max(0LL, value));
+        else if (key == "proof")
+            mProofNodes = std::max(0LL, value);
+        else if (key == "cache")
+            mCacheMegabytes = static_cast<size_t>(std::max(1LL, value));
+        else
+            return false;
+    }
+
+    return true;
+}
+
+Game EngineConfig::MakeGame(bool isCpuFirst, int gridSize) const
+{
+    Game game(mLevel, isCpuFirst, gridSize);
+    ApplyLimits(game);
+    return game;
+}
+
+Game EngineConfig::MakeGame(const PositionCode& code) const
+{
+    Game game(code, mLevel);
+    ApplyLimits(game);
+    return game;
+}
+
+void EngineConfig::ApplyLimits(Game& game) const
+{
+    long long nodes = mNodes > 0 ? mNodes : Game::GetLevelSettings(mLevel).mNodeBudget;
+    game.SetTimePerMove(mMoveTime > 0 ? mMoveTime : nodes > 0 ? Game::NoTimeLimit : Game::CpuTimePerMoveMs);
+    if (mNodes > 0)
+        game.SetNodeBudget(mNodes);
+    if (mEndgameEmpties >= 0)
+        game.SetEndgameEmpties(mEndgameEmpties);
+    if (mProofNodes >= 0)
+        game.SetProofNodes(mProofNodes);
+}
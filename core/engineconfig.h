@@ -0,0 +1,40 @@
+#ifndef ENGINECONFIG_H
+#define ENGINECONFIG_H
+
+#include <cstddef>
+#include <string>
+#include "game.h"
+#include "searchcache.h"
+
+// Search settings of an engine in the command line tools, written as a comma
+// separated list of key=value, e.g. "level=4,nodes=20000,proof=0": the level
+// (0-4), a node budget and a time limit per move, the endgame and proof-number
+// search limits (by default those of the level), the search cache size in MB, a
+// position statistics file and a pattern evaluation weights file. Without a
+// node budget the level keeps its own. A search with a node budget is only
+// timed when movetime is given, so it stays reproducible, one without runs on
+// movetime or the default move time.
+struct EngineConfig
+{
+    Game::Level mLevel = Game::Level::Max;
+    long long mNodes = 0;       // 0 keeps the budget of the level
+    int mMoveTime = 0;          // 0 for none, see above
+    int mEndgameEmpties = -1;   // -1 keeps the default of the level
+    long long mProofNodes = -1;
+    size_t mCacheMegabytes = SearchCache::DefaultMegabytes;
+    std::string mStatsPath;
+    std::string mEvalPath;
+
+    static const char* GetUsage() {return "level=<0-4>,nodes=<n>,movetime=<ms>,endgame=<n>,proof=<n>,cache=<mb>,stats=<file>,eval=<file>";}
+
+    bool Parse(const std::string& text);
+    // a game of the level with the search limits applied, cache, stats and weights are left to the caller
+    Game MakeGame(bool isCpuFirst, int gridSize) const;
+    // the same for the position of a valid code
+    Game MakeGame(const PositionCode& code) const;
+
+private:
+    void ApplyLimits(Game& game) const;
+};
+
+#endif // ENGINECONFIG_H
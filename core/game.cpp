@@ -0,0 +1,961 @@
+#include "game.h"
+#include "searchcache.h"
+#include "positionstats.h"
+#include "proofsearch.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// cached scores are relative to the cached node, wins and losses are stored
+// as distance from it rather than from the root of the search that found them
+static int ToCacheScore(Game::Score score, int depth)
+{
+    if (score > Game::ScoreDefines::Draw)
+        return score + depth;
+    if (score < Game::ScoreDefines::Draw)
+        return score - depth;
+    return score;
+}
+
+static Game::Score FromCacheScore(int score, int depth)
+{
+    if (score > Game::ScoreDefines::Draw)
+        return score - depth;
+    if (score < Game::ScoreDefines::Draw)
+        return score + depth;
+    return score;
+}
+
+Game::Game(const PositionCode& code, Level level)
+    : Game(level, false, code.mGridSize)
+{
+    assert(code.IsValid());
+
+    int cpu = 0, user = 0;
+    for (int cell = 0; cell < code.mGridSize * code.mGridSize; cell++)
+    {
+        PositionCode::Cell value = code.GetCell(cell);
+        if (value == PositionCode::Empty)
+            continue;
+
+        SetCell(cell / code.mGridSize, cell % code.mGridSize, value == PositionCode::Cpu ? PlayerEntity::Cpu : PlayerEntity::User);
+        (value == PositionCode::Cpu ? cpu : user)++;
+    }
+
+    // with equal counts the side to move also moved first
+    mMoves = cpu + user;
+    mCpuFirst = cpu > user || (cpu == user && code.mIsCpuToMove);
+    mTurn = code.mIsCpuToMove ? PlayerEntity::Cpu : PlayerEntity::User;
+
+    for (const LineCount& count : mLineCounts)
+    {
+        if (count.mCpu == GetGridSize())
+            mWinner = PlayerEntity::Cpu;
+        else if (count.mUser == GetGridSize())
+            mWinner = PlayerEntity::User;
+    }
+
+    if (mWinner != PlayerEntity::None || mMoves == GetGridSize() * GetGridSize())
+        mTurn = PlayerEntity::None;
+}
+
+PositionCode Game::GetPositionCode() const
+{
+    // the side that would move next by turns, also once the game is over
+    bool isCpuToMove = mCpuFirst == (mMoves % 2 == 0);
+    PositionCode code = PositionCode::MakeEmpty(GetGridSize(), isCpuToMove);
+    for (int i = 0; i < GetGridSize(); i++)
+        for (int j = 0; j < GetGridSize(); j++)
+            if (mGrid[i][j] != PlayerEntity::None)
+                code.SetCell(i * GetGridSize() + j, mGrid[i][j] == PlayerEntity::Cpu ? PositionCode::Cpu : PositionCode::User);
+    return code;
+}
+
+bool Game::ComputeIsOver(Position last, int moves, PlayerEntity& winner) const
+{
+    // the line counts already include the last move, only its lines can be complete
+    int cell = last.mX * GetGridSize() + last.mY;
+    PlayerEntity player = mGrid[last.mX][last.mY];
+    winner = PlayerEntity::None;
+
+    for (int k = 0; k < mGeometry->mCellLineCount[cell]; k++)
+    {
+        const LineCount& count = mLineCounts[mGeometry->mCellLines[cell][k]];
+        if ((player == PlayerEntity::Cpu ? count.mCpu : count.mUser) == GetGridSize())
+        {
+            winner = player;
+            return true;
+        }
+    }
+
+    return moves == (GetGridSize() * GetGridSize());
+}
+
+Game::Position Game::ComputeCpuMove()
+{
+    TRACE_SCOPE("Game::ComputeCpuMove");
+    Game::Position p;
+
+    mInfo = SearchInfo();
+
+    // the opening and the random moves are played without a search, their score is unknown
+    if (mMoves == 0 || (mBlunderPercent > 0 && GetRandom(100) < mBlunderPercent))
+    {
+        p = mMoves == 0 ? Position(mGeometry->mCenter / GetGridSize(), mGeometry->mCenter % GetGridSize()) :
+                          ComputeRandomMove();
+        mInfo.mScore = ScoreDefines::TooComplex;
+    }
+    else
+        p = ComputeMinMaxBestMove();
+
+    mInfo.mBestMove = p;
+    return p;
+}
+
+Game::Position Game::ComputeRandomMove()
+{
+    Game::Position p;
+
+    int remaining = GetGridSize() * GetGridSize() - mMoves;
+    int selected = remaining == 1 ? 0 : GetRandom(remaining);
+
+    for (int i = 0; i != GetGridSize(); i++)
+        for (int j = 0; j != GetGridSize(); j++)
+            if (mGrid[i][j] == PlayerEntity::None && selected-- == 0)
+            {
+                p.mX = i;
+                p.mY = j;
+            }
+
+    assert(p.mX != -1 && p.mY != -1);
+    return p;
+}
+
+bool Game::FindForcedMove(std::chrono::steady_clock::time_point moveStart, Position& p, Score& score)
+{
+    // wins, forced blocks and forks are answered without a search
+    if (FindTacticalMove(p, score))
+        return true;
+
+    SearchCache::Entry entry;
+    if (mCache && mCache->Probe(GetNodeKey(true), entry) && entry.mBound == SearchCache::Exact &&
+            entry.mBestMove != SearchCache::NoMove)
+    {
+        Position cached(entry.mBestMove / GetGridSize(), entry.mBestMove % GetGridSize());
+        if (mGrid[cached.mX][cached.mY] == PlayerEntity::None)
+        {
+            p = cached;
+            score = FromCacheScore(entry.mScore, 0);
+            return true;
+        }
+    }
+
+    // a forced win can be too deep for minimax on larger grids, try to prove one first;
+    // on the clock it gets at most half the move time and minimax the rest
+    if (mProofNodes > 0)
+    {
+        TRACE_SCOPE("Game::ProveWin");
+        ProofSearch proof(ProofSearch::DefaultMaxEntries / 16);
+        proof.SetStopFlag(mStop);
+        if (mTimePerMove != NoTimeLimit)
+            proof.SetDeadline(moveStart + std::chrono::milliseconds(mTimePerMove / 2));
+        ProofSearch::Result result = proof.Prove(*this, mProofNodes);
+        mInfo.mNodes += result.mNodes;
+        if (result.mOutcome == ProofSearch::Outcome::Win)
+        {
+            // the length of the win is unknown, it cannot take more plies than there are empty cells
+            p = result.mBestMove;
+            score = ScoreDefines::CpuWin - (GetGridSize() * GetGridSize() - mMoves);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Game::Position Game::ComputeMinMaxBestMove()
+{
+    Score bestScore = ScoreDefines::UndefinedMin;
+    Game::Position bestMove;
+
+    std::vector<Position> undefinedMoves;
+
+    if (mCache)
+        mCache->NewSearch();
+
+    auto moveStart = std::chrono::steady_clock::now();
+    if (FindForcedMove(moveStart, bestMove, bestScore))
+    {
+        mInfo.mBestMove = bestMove;
+        mInfo.mScore = bestScore;
+        if (mInfoCallback)
+            mInfoCallback(mInfo);
+        return bestMove;
+    }
+
+    // equivalent cells of a symmetric position get the same score, search one of each
+    int symmetries[SymmetryCount];
+    int symmetryCount = FindSymmetries(symmetries);
+    std::vector<Position> candidates;
+    for (int i = 0; i < GetGridSize(); i++)
+        for (int j = 0; j < GetGridSize(); j++)
+            if (mGrid[i][j] == PlayerEntity::None && IsOrbitRepresentative(i, j, symmetries, symmetryCount))
+                candidates.push_back({i, j});
+
+    // moves that did well in played games first, the first of equal scores is kept
+    if (mStats)
+        OrderByStats(candidates);
+
+    int aborts = mAborts;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - moveStart).count();
+    mTimePerTree = std::max(0, mTimePerMove - static_cast<int>(elapsed)) / (int)candidates.size();
+    mNodesPerTree = mNodeBudget / (int)candidates.size();
+
+    for (Position p : candidates)
+    {
+        // once stopped, remaining moves are only kept as a fallback
+        if (IsStopRequested() && bestMove.mX != -1)
+        {
+            mAborts++;
+            continue;
+        }
+
+        bool isExact;
+        Score currentScore = SearchRootMove(p, true, isExact);
+
+        if (currentScore > bestScore || bestMove.mX == -1)
+        {
+            bestMove = p;
+            bestScore = currentScore;
+        }
+
+        if (currentScore == TooComplex)
+            undefinedMoves.push_back(p);
+
+        mInfo.mBestMove = bestMove;
+        mInfo.mScore = bestScore;
+        if (mInfoCallback)
+            mInfoCallback(mInfo);
+    }
+
+    assert(std::abs(bestScore) <= ScoreDefines::CpuWin);
+
+    if (aborts == mAborts)
+        StoreInCache(true, 0, bestScore, bestMove.mX * GetGridSize() + bestMove.mY);
+
+    if (bestScore == TooComplex)
+        bestMove = mStats ? undefinedMoves.front() : undefinedMoves[GetRandom((int)undefinedMoves.size())];
+
+    if (symmetryCount == 0)
+        return bestMove;
+
+    // any cell of the orbit is as good, pick one for variety
+    std::vector<Position> orbit(1, bestMove);
+    for (int k = 0; k < symmetryCount; k++)
+    {
+        int cell = mGeometry->mSymmetry[symmetries[k]][bestMove.mX * GetGridSize() + bestMove.mY];
+        Position image(cell / GetGridSize(), cell % GetGridSize());
+        if (std::none_of(orbit.begin(), orbit.end(), [image](Position p) {return p.mX == image.mX && p.mY == image.mY;}))
+            orbit.push_back(image);
+    }
+
+    return orbit[orbit.size() == 1 ? 0 : GetRandom((int)orbit.size())];
+}
+
+Game::Score Game::ComputeMinMaxScore(Position lastMove, int depth, bool isCpu)
+{
+    mInfo.mNodes++;
+    mInfo.mDepth = std::max(mInfo.mDepth, depth);
+
+    bool isCutOff = depth > DepthMin && (IsTreeBudgetExhausted() || IsStopRequested() || (mDepthMax > 0 && depth > mDepthMax));
+    if (isCutOff && !mPatternWeights)
+    {
+        mAborts++;
+        return ScoreDefines::TooComplex;
+    }
+
+    Game::PlayerEntity winner;
+    if (ComputeIsOver(lastMove, mMoves + depth, winner))
+    {
+        switch (winner)
+        {
+        case Game::PlayerEntity::None: return ScoreDefines::Draw;
+        case Game::PlayerEntity::Cpu: return ScoreDefines::CpuWin - depth;
+        case Game::PlayerEntity::User: return ScoreDefines::CpuLose + depth;
+        }
+    }
+
+    // with an evaluation a finished game still gets its exact score, anything else an estimate
+    if (isCutOff)
+    {
+        mAborts++;
+        return GetPatternScore(isCpu);
+    }
+
+    SearchCache::Entry entry;
+    if (mCache && mCache->Probe(GetNodeKey(isCpu), entry) && entry.mBound == SearchCache::Exact)
+        return FromCacheScore(entry.mScore, depth);
+
+    // small enough to solve outright, depth limited levels stay on the normal search
+    int empties = GetGridSize() * GetGridSize() - mMoves - depth;
+    if (empties <= mEndgameEmpties && mDepthMax == 0)
+    {
+        int bestCell;
+        Score score;
+        if (!ComputeEndgameScore(depth, isCpu, true, score, bestCell))
+        {
+            mAborts++;
+            return mPatternWeights ? GetPatternScore(isCpu) : ScoreDefines::TooComplex;
+        }
+
+        StoreInCache(isCpu, depth, score, bestCell);
+        return score;
+    }
+
+    // an immediate win ends the search, a single threat of the opponent leaves
+    // only the block and two threats cannot all be blocked
+    PlayerEntity player = isCpu ? PlayerEntity::Cpu : PlayerEntity::User;
+    PlayerEntity opponent = isCpu ? PlayerEntity::User : PlayerEntity::Cpu;
+    int threats[2];
+    if (FindThreats(player, threats, 1) > 0)
+        return isCpu ? ScoreDefines::CpuWin - depth - 1 : ScoreDefines::CpuLose + depth + 1;
+
+    int forced = FindThreats(opponent, threats, 2);
+    if (forced > 1)
+        return isCpu ? ScoreDefines::CpuLose + depth + 2 : ScoreDefines::CpuWin - depth - 2;
+
+    int symmetries[SymmetryCount];
+    int symmetryCount = depth <= SymmetryPlies && forced == 0 ? FindSymmetries(symmetries) : 0;
+
+    int aborts = mAborts;
+    Score bestScore = isCpu ? ScoreDefines::UndefinedMin : ScoreDefines::UndefinedMax;
+    int bestCell = SearchCache::NoMove;
+
+    for (int i = 0; i < GetGridSize(); i++)
+    {
+        for (int j = 0; j < GetGridSize(); j++)
+        {
+            if (mGrid[i][j] != PlayerEntity::None)
+                continue;
+
+            if (forced == 1 && threats[0] != i * GetGridSize() + j)
+                continue;
+
+            if (symmetryCount > 0 && !IsOrbitRepresentative(i, j, symmetries, symmetryCount))
+                continue;
+
+            SetCell(i, j, isCpu ? PlayerEntity::Cpu : PlayerEntity::User);
+            Score currentScore = ComputeMinMaxScore({i, j}, depth + 1, !isCpu);
+            if (isCpu ? currentScore > bestScore : currentScore < bestScore)
+            {
+                bestScore = currentScore;
+                bestCell = i * GetGridSize() + j;
+            }
+            ClearCell(i, j);
+        }
+    }
+
+    assert(std::abs(bestScore) <= ScoreDefines::CpuWin);
+
+    // only fully searched subtrees are exact
+    if (aborts == mAborts)
+        StoreInCache(isCpu, depth, bestScore, bestCell);
+
+    return bestScore;
+}
+
+void Game::OrderByStats(std::vector<Position>& moves) const
+{
+    TRACE_SCOPE("Game::OrderByStats");
+    // expected score of the CPU after each move, unplayed positions count as even
+    PositionCode code = GetPositionCode();
+    code.mIsCpuToMove = false;
+    double expected[MaxBitboardCells];
+    for (Position p : moves)
+    {
+        int cell = p.mX * GetGridSize() + p.mY;
+        code.SetCell(cell, PositionCode::Cpu);
+
+        // the record is from the view of the user, who is to move
+        PositionStats::Record record;
+        expected[cell] = 0.5;
+        if (mStats->Find(PositionStats::GetKey(code), record))
+            expected[cell] = (record.mLosses + 0.5 * record.mDraws + 1.0) / (record.mWins + record.mDraws + record.mLosses + 2.0);
+
+        code.SetCell(cell, PositionCode::Empty);
+    }
+
+    int gridSize = GetGridSize();
+    std::stable_sort(moves.begin(), moves.end(), [&expected, gridSize](Position a, Position b)
+    {
+        return expected[a.mX * gridSize + a.mY] > expected[b.mX * gridSize + b.mY];
+    });
+}
+
+Game::Score Game::SearchRootMove(Position p, bool isCpu, bool& isExact)
+{
+    TRACE_SCOPE("Game::SearchRootMove");
+    int aborts = mAborts;
+    SetCell(p.mX, p.mY, isCpu ? PlayerEntity::Cpu : PlayerEntity::User);
+    mTreeStart = std::chrono::steady_clock::now();
+    mTreeStartNodes = mInfo.mNodes;
+    Score score = ComputeMinMaxScore(p, 1, !isCpu);
+    ClearCell(p.mX, p.mY);
+
+    isExact = aborts == mAborts;
+    return score;
+}
+
+std::vector<Game::MoveLine> Game::FindCpuMoves(int count)
+{
+    TRACE_SCOPE("Game::FindCpuMoves");
+    std::vector<MoveLine> moves;
+    if (mTurn == PlayerEntity::None || count <= 0)
+        return moves;
+
+    mInfo = SearchInfo();
+    if (mCache)
+        mCache->NewSearch();
+
+    // the move FindCpuMove would play without a search goes first whatever the search
+    // finds, the random moves of the lower levels aside
+    auto moveStart = std::chrono::steady_clock::now();
+    Position forced;
+    Score forcedScore = ScoreDefines::TooComplex;
+    bool isForced = mMoves == 0;
+    if (isForced)
+        forced = {mGeometry->mCenter / GetGridSize(), mGeometry->mCenter % GetGridSize()};
+    else
+        isForced = FindForcedMove(moveStart, forced, forcedScore);
+
+    // minimax scores every root move fully, one pass gives all of them; symmetric
+    // cells share the score and the line of their representative
+    int symmetries[SymmetryCount];
+    int symmetryCount = FindSymmetries(symmetries);
+    std::vector<Position> representatives;
+    for (int i = 0; i < GetGridSize(); i++)
+        for (int j = 0; j < GetGridSize(); j++)
+            if (mGrid[i][j] == PlayerEntity::None && IsOrbitRepresentative(i, j, symmetries, symmetryCount))
+                representatives.push_back({i, j});
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - moveStart).count();
+    mTimePerTree = std::max(0, mTimePerMove - static_cast<int>(elapsed)) / (int)representatives.size();
+    mNodesPerTree = mNodeBudget / (int)representatives.size();
+
+    int aborts = mAborts;
+    for (Position p : representatives)
+    {
+        MoveLine move;
+        move.mMove = p;
+        move.mScore = SearchRootMove(p, true, move.mIsExact);
+        move.mLine = CollectLine(p, true);
+
+        int cell = p.mX * GetGridSize() + p.mY;
+        for (int k = -1; k < symmetryCount; k++)
+        {
+            const uint8_t* transform = k < 0 ? nullptr : mGeometry->mSymmetry[symmetries[k]];
+            int image = transform ? transform[cell] : cell;
+            if (std::any_of(moves.begin(), moves.end(), [this, image](const MoveLine& other)
+                    {return other.mMove.mX * GetGridSize() + other.mMove.mY == image;}))
+                continue;
+
+            MoveLine imageMove = move;
+            if (transform)
+                for (Position& q : imageMove.mLine)
+                {
+                    int mapped = transform[q.mX * GetGridSize() + q.mY];
+                    q = {mapped / GetGridSize(), mapped % GetGridSize()};
+                }
+            imageMove.mMove = imageMove.mLine.front();
+            moves.push_back(imageMove);
+        }
+
+        if (move.mScore > mInfo.mScore || mInfo.mBestMove.mX == -1)
+        {
+            mInfo.mBestMove = move.mMove;
+            mInfo.mScore = move.mScore;
+        }
+        if (mInfoCallback)
+            mInfoCallback(mInfo);
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const MoveLine& a, const MoveLine& b) {return a.mScore > b.mScore;});
+    if (aborts == mAborts)
+        StoreInCache(true, 0, moves.front().mScore, moves.front().mMove.mX * GetGridSize() + moves.front().mMove.mY);
+
+    if (isForced)
+    {
+        int cell = forced.mX * GetGridSize() + forced.mY;
+        auto found = std::find_if(moves.begin(), moves.end(), [this, cell](const MoveLine& move)
+                {return move.mMove.mX * GetGridSize() + move.mMove.mY == cell;});
+
+        // a known score beats a bound from the search, an exact one is kept
+        if (!found->mIsExact && forcedScore != ScoreDefines::TooComplex)
+            found->mScore = forcedScore;
+        std::rotate(moves.begin(), found, found + 1);
+        mInfo.mBestMove = found->mMove;
+        mInfo.mScore = moves.front().mScore;
+    }
+
+    if ((int)moves.size() > count)
+        moves.resize(count);
+    return moves;
+}
+
+std::vector<Game::Position> Game::CollectLine(Position first, bool isCpu)
+{
+    std::vector<Position> line(1, first);
+    SetCell(first.mX, first.mY, isCpu ? PlayerEntity::Cpu : PlayerEntity::User);
+
+    // follow the best moves of exact cache entries, where the search stored nothing
+    // a win on the board, the block of a single threat or a solved endgame extends it
+    PlayerEntity winner;
+    while (!ComputeIsOver(line.back(), mMoves + (int)line.size(), winner))
+    {
+        isCpu = !isCpu;
+        PlayerEntity player = isCpu ? PlayerEntity::Cpu : PlayerEntity::User;
+        PlayerEntity opponent = isCpu ? PlayerEntity::User : PlayerEntity::Cpu;
+
+        int cell = SearchCache::NoMove;
+        int threats[2];
+        SearchCache::Entry entry;
+        if (mCache && mCache->Probe(GetNodeKey(isCpu), entry) && entry.mBound == SearchCache::Exact &&
+                entry.mBestMove != SearchCache::NoMove)
+            cell = entry.mBestMove;
+        else if (FindThreats(player, threats, 1) > 0 || FindThreats(opponent, threats, 2) == 1)
+            cell = threats[0];
+        else if (GetGridSize() * GetGridSize() - mMoves - (int)line.size() <= mEndgameEmpties)
+        {
+            Score score;
+            ComputeEndgameScore((int)line.size(), isCpu, false, score, cell);
+        }
+
+        Position p(cell / GetGridSize(), cell % GetGridSize());
+        if (cell == SearchCache::NoMove || mGrid[p.mX][p.mY] != PlayerEntity::None)
+            break;
+
+        SetCell(p.mX, p.mY, player);
+        line.push_back(p);
+    }
+
+    for (auto it = line.rbegin(); it != line.rend(); ++it)
+        ClearCell(it->mX, it->mY);
+
+    return line;
+}
+
+void Game::Analyze(const AnalysisCallback& callback)
+{
+    TRACE_SCOPE("Game::Analyze");
+    if (mTurn == PlayerEntity::None)
+        return;
+
+    bool isCpu = mTurn == PlayerEntity::Cpu;
+    int gridSize = GetGridSize();
+    int empties = gridSize * gridSize - mMoves;
+
+    std::vector<CellAnalysis> cells;
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            if (mGrid[i][j] == PlayerEntity::None)
+                cells.push_back({{i, j}});
+
+    // the depth limit takes the place of the clock, only the stop flag ends it early
+    mInfo = SearchInfo();
+    mNodeBudget = 0;
+    mTimePerTree = std::numeric_limits<int>::max();
+    if (mCache)
+        mCache->NewSearch();
+
+    for (int depth = DepthMin + 1; ; depth++)
+    {
+        // the last round has no limit and may use the endgame solver
+        bool isLast = depth >= empties;
+        mDepthMax = isLast ? 0 : depth;
+
+        bool isSolved = true;
+        for (auto& cell : cells)
+        {
+            if (cell.mIsExact)
+                continue;
+
+            if (IsStopRequested())
+                return;
+
+            Score score = SearchRootMove(cell.mCell, isCpu, cell.mIsExact);
+            cell.mScore = isCpu || score == ScoreDefines::TooComplex ? score : -score;
+            isSolved = isSolved && cell.mIsExact;
+        }
+
+        if (IsStopRequested())
+            return;
+
+        callback(cells, depth);
+        if (isSolved || isLast)
+            return;
+    }
+}
+
+Game::LevelSettings Game::GetLevelSettings(Level level)
+{
+    // weaker levels cap the work per move so their cost is known up front
+    switch (level)
+    {
+    case Level::Random: return {0, 0, 100};
+    case Level::Easy: return {2000, 3, 25};
+    case Level::Medium: return {20000, 5, 10};
+    case Level::Hard: return {200000, 0, 0};
+    case Level::Max:
+    default: return {0, 0, 0};
+    }
+}
+
+bool Game::IsTreeBudgetExhausted() const
+{
+    if (mNodeBudget > 0)
+    {
+        if (mInfo.mNodes - mTreeStartNodes > mNodesPerTree)
+            return true;
+        if (mTimePerMove == NoTimeLimit)
+            return false;
+    }
+
+    return std::chrono::steady_clock::now() - mTreeStart > std::chrono::milliseconds(mTimePerTree);
+}
+
+bool Game::ComputeEndgameScore(int depth, bool isCpu, bool isBounded, Score& score, int& bestCell)
+{
+    int gridSize = GetGridSize();
+    uint64_t cpu = 0, user = 0;
+    int empty[MaxBitboardCells];
+    int count = 0;
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (int j = 0; j < gridSize; j++)
+        {
+            int cell = i * gridSize + j;
+            switch (mGrid[i][j])
+            {
+            case PlayerEntity::None: empty[count++] = cell; break;
+            case PlayerEntity::Cpu: cpu |= uint64_t(1) << cell; break;
+            case PlayerEntity::User: user |= uint64_t(1) << cell; break;
+            }
+        }
+    }
+
+    // the root runs with a full window, its best move is exact even though the subtrees are cut
+    bestCell = SearchCache::NoMove;
+    mIsEndgameBounded = isBounded;
+    mIsEndgameAborted = false;
+    score = SolveEndgame(cpu, user, empty, count, depth, isCpu, ScoreDefines::UndefinedMin, ScoreDefines::UndefinedMax,
+                         &bestCell);
+    return !mIsEndgameAborted;
+}
+
+Game::Score Game::SolveEndgame(uint64_t cpu, uint64_t user, int* empty, int count, int depth, bool isCpu, Score alpha, Score beta,
+                               int* bestCell)
+{
+    // the result has to be exact, a solve cut short by the limits of the search is dropped as a whole;
+    // the clock is only read every few nodes
+    if (mIsEndgameBounded && (mIsEndgameAborted || ((mInfo.mNodes & (EndgamePollNodes - 1)) == 0 &&
+            (IsTreeBudgetExhausted() || IsStopRequested()))))
+    {
+        mIsEndgameAborted = true;
+        return ScoreDefines::Draw;
+    }
+
+    mInfo.mNodes++;
+    mInfo.mDepth = std::max(mInfo.mDepth, depth);
+
+    Score win = isCpu ? ScoreDefines::CpuWin - depth - 1 : ScoreDefines::CpuLose + depth + 1;
+    for (int k = 0; k < count; k++)
+        if (CompletesLine((isCpu ? cpu : user) | uint64_t(1) << empty[k], empty[k]))
+        {
+            if (bestCell)
+                *bestCell = empty[k];
+            return win;
+        }
+
+    if (count == 1)
+    {
+        if (bestCell)
+            *bestCell = empty[0];
+        return ScoreDefines::Draw;
+    }
+
+    Score bestScore = isCpu ? ScoreDefines::UndefinedMin : ScoreDefines::UndefinedMax;
+    for (int k = 0; k < count; k++)
+    {
+        int cell = empty[k];
+        uint64_t bit = uint64_t(1) << cell;
+        std::swap(empty[k], empty[count - 1]);
+
+        Score score;
+        if (isCpu)
+            score = SolveEndgame(cpu | bit, user, empty, count - 1, depth + 1, false, alpha, beta);
+        else
+            score = SolveEndgame(cpu, user | bit, empty, count - 1, depth + 1, true, alpha, beta);
+
+        if (isCpu ? score > bestScore : score < bestScore)
+        {
+            bestScore = score;
+            if (bestCell)
+                *bestCell = cell;
+        }
+        if (isCpu)
+            alpha = std::max(alpha, bestScore);
+        else
+            beta = std::min(beta, bestScore);
+
+        std::swap(empty[k], empty[count - 1]);
+        if (alpha >= beta || mIsEndgameAborted)
+            break;
+    }
+
+    return bestScore;
+}
+
+bool Game::CompletesLine(uint64_t cells, int cell) const
+{
+    for (int k = 0; k < mGeometry->mCellLineCount[cell]; k++)
+    {
+        uint64_t line = mGeometry->mLineMasks[mGeometry->mCellLines[cell][k]];
+        if ((cells & line) == line)
+            return true;
+    }
+    return false;
+}
+
+void Game::SetCell(int i, int j, PlayerEntity player)
+{
+    mGrid[i][j] = player;
+    mHash ^= CellKey(i * GetGridSize() + j, player);
+    UpdateLineCounts(i, j, player, 1);
+    if (mPatternWeights)
+        UpdatePatternIndexes(i * GetGridSize() + j, player, 1);
+}
+
+void Game::ClearCell(int i, int j)
+{
+    mHash ^= CellKey(i * GetGridSize() + j, mGrid[i][j]);
+    UpdateLineCounts(i, j, mGrid[i][j], -1);
+    if (mPatternWeights)
+        UpdatePatternIndexes(i * GetGridSize() + j, mGrid[i][j], -1);
+    mGrid[i][j] = PlayerEntity::None;
+}
+
+void Game::SetPatternEval(const PatternEval* eval)
+{
+    mPatternLayout = nullptr;
+    mPatternWeights = nullptr;
+    if (!eval || !eval->HasWeights(GetGridSize()))
+        return;
+
+    mPatternLayout = &PatternEval::GetLayout(GetGridSize());
+    mPatternWeights = eval->GetWeights(GetGridSize());
+    for (int t = 0; t < mPatternLayout->mTupleCount; t++)
+        mPatternIndexes[0][t] = mPatternIndexes[1][t] = mPatternLayout->mTupleBase[t];
+
+    for (int i = 0; i < GetGridSize(); i++)
+        for (int j = 0; j < GetGridSize(); j++)
+            if (mGrid[i][j] != PlayerEntity::None)
+                UpdatePatternIndexes(i * GetGridSize() + j, mGrid[i][j], 1);
+}
+
+void Game::UpdatePatternIndexes(int cell, PlayerEntity player, int delta)
+{
+    // a stone counts 1 for the side to move and 2 for the other side
+    int cpuDigit = player == PlayerEntity::Cpu ? delta : 2 * delta;
+    int userDigit = 3 * delta - cpuDigit;
+    for (int k = 0; k < mPatternLayout->mCellTupleCount[cell]; k++)
+    {
+        const PatternEval::CellTuple& tuple = mPatternLayout->mCellTuples[cell][k];
+        mPatternIndexes[0][tuple.mTuple] += cpuDigit * tuple.mPower;
+        mPatternIndexes[1][tuple.mTuple] += userDigit * tuple.mPower;
+    }
+}
+
+Game::Score Game::GetPatternScore(bool isCpu) const
+{
+    // the value is for the side to move; even scores can be negated without turning into TooComplex
+    float value = PatternEval::ToValue(PatternEval::Sum(mPatternWeights, mPatternIndexes[isCpu ? 0 : 1], mPatternLayout->mTupleCount));
+    Score score = 2 * static_cast<Score>(std::lround(value * (PatternScale / 2)));
+    return isCpu ? score : -score;
+}
+
+void Game::UpdateLineCounts(int i, int j, PlayerEntity player, int delta)
+{
+    int cell = i * GetGridSize() + j;
+    for (int k = 0; k < mGeometry->mCellLineCount[cell]; k++)
+    {
+        LineCount& count = mLineCounts[mGeometry->mCellLines[cell][k]];
+        (player == PlayerEntity::Cpu ? count.mCpu : count.mUser) += delta;
+    }
+}
+
+int Game::FindThreats(PlayerEntity player, int* cells, int maxCells) const
+{
+    int gridSize = GetGridSize();
+    int found = 0;
+
+    for (int line = 0; line < static_cast<int>(mLineCounts.size()) && found < maxCells; line++)
+    {
+        const LineCount& count = mLineCounts[line];
+        int own = player == PlayerEntity::Cpu ? count.mCpu : count.mUser;
+        int other = player == PlayerEntity::Cpu ? count.mUser : count.mCpu;
+        if (own != gridSize - 1 || other != 0)
+            continue;
+
+        // the only empty cell of the line completes it
+        for (int k = 0; k < gridSize; k++)
+        {
+            int cell = mGeometry->mLineCells[line][k];
+            if (mGrid[cell / gridSize][cell % gridSize] != PlayerEntity::None)
+                continue;
+
+            if (std::find(cells, cells + found, cell) == cells + found)
+                cells[found++] = cell;
+            break;
+        }
+    }
+
+    return found;
+}
+
+int Game::FindFork(PlayerEntity player) const
+{
+    int gridSize = GetGridSize();
+    auto isOpen = [this, player, gridSize](const LineCount& count)
+    {
+        int own = player == PlayerEntity::Cpu ? count.mCpu : count.mUser;
+        int other = player == PlayerEntity::Cpu ? count.mUser : count.mCpu;
+        return own == gridSize - 2 && other == 0;
+    };
+
+    // a move turning two lines into threats at once, two lines only share that cell
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (int j = 0; j < gridSize; j++)
+        {
+            if (mGrid[i][j] != PlayerEntity::None)
+                continue;
+
+            int cell = i * gridSize + j;
+            int lines = 0;
+            for (int k = 0; k < mGeometry->mCellLineCount[cell]; k++)
+                lines += isOpen(mLineCounts[mGeometry->mCellLines[cell][k]]);
+
+            if (lines >= 2)
+                return cell;
+        }
+    }
+
+    return -1;
+}
+
+bool Game::FindTacticalMove(Position& p, Score& score) const
+{
+    int gridSize = GetGridSize();
+    int cells[2];
+
+    if (FindThreats(PlayerEntity::Cpu, cells, 1) > 0)
+    {
+        score = ScoreDefines::CpuWin - 1;
+    }
+    else if (int threats = FindThreats(PlayerEntity::User, cells, 2))
+    {
+        // the block is forced, its outcome is only known when both cannot be blocked
+        score = threats > 1 ? ScoreDefines::CpuLose + 2 : ScoreDefines::TooComplex;
+    }
+    else if ((cells[0] = FindFork(PlayerEntity::Cpu)) != -1)
+    {
+        score = ScoreDefines::CpuWin - 3;
+    }
+    else
+    {
+        return false;
+    }
+
+    p = {cells[0] / gridSize, cells[0] % gridSize};
+    return true;
+}
+
+void Game::SetSearchCache(SearchCache* cache)
+{
+    mCache = cache && cache->GetGridSize() == GetGridSize() ? cache : nullptr;
+}
+
+void Game::StoreInCache(bool isCpu, int depth, Score score, int bestCell)
+{
+    if (!mCache)
+        return;
+
+    int remaining = GetGridSize() * GetGridSize() - mMoves - depth;
+    mCache->Store(GetNodeKey(isCpu), ToCacheScore(score, depth), remaining, SearchCache::Exact, bestCell);
+}
+
+int Game::FindSymmetries(int* transforms) const
+{
+    int gridSize = GetGridSize();
+    int count = 0;
+
+    // transform 0 is the identity, the others are the rotations and reflections of the square
+    for (int transform = 1; transform < SymmetryCount; transform++)
+    {
+        bool isSymmetric = true;
+        for (int i = 0; i < gridSize && isSymmetric; i++)
+        {
+            for (int j = 0; j < gridSize && isSymmetric; j++)
+            {
+                int image = mGeometry->mSymmetry[transform][i * gridSize + j];
+                isSymmetric = mGrid[i][j] == mGrid[image / gridSize][image % gridSize];
+            }
+        }
+
+        if (isSymmetric)
+            transforms[count++] = transform;
+    }
+
+    return count;
+}
+
+bool Game::IsOrbitRepresentative(int i, int j, const int* transforms, int count) const
+{
+    // the representative is the orbit cell with the lowest index
+    int gridSize = GetGridSize();
+    for (int k = 0; k < count; k++)
+        if (mGeometry->mSymmetry[transforms[k]][i * gridSize + j] < i * gridSize + j)
+            return false;
+
+    return true;
+}
+
+std::string Game::PositionToString(Position p)
+{
+    if (p.mX < 0 || p.mY < 0)
+        return "none";
+
+    return std::string(1, static_cast<char>('a' + p.mY)) + std::to_string(p.mX + 1);
+}
+
+Game::Position Game::PositionFromString(const std::string& text)
+{
+    if (text.size() < 2 || text[0] < 'a' || text[0] > 'z')
+        return {};
+
+    int row = 0;
+    for (size_t i = 1; i < text.size(); i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+            return {};
+        row = row * 10 + (text[i] - '0');
+    }
+
+    if (row == 0)
+        return {};
+
+    return {row - 1, text[0] - 'a'};
+}
@@ -0,0 +1,363 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include "geometry.h"
+#include "patterneval.h"
+#include "positioncode.h"
+#include "random.h"
+
+class SearchCache;
+class PositionStats;
+
+struct Game
+{
+public:
+    using Score = int;
+
+    enum
+    {
+        DepthMin = 2,
+        CpuTimePerMoveMs = 1000,
+        NoTimeLimit = std::numeric_limits<int>::max(),
+        EngineVersion = 1,
+        EndgameEmpties = 10,
+        MaxBitboardCells = Geometry::MaxCells,
+        SymmetryPlies = 2,
+        SymmetryCount = Geometry::SymmetryCount,
+        ProofNodes = 20000,
+        PatternScale = 500,     // estimates stay well inside the proven scores
+        EndgamePollNodes = 256,
+    };
+
+    enum ScoreDefines
+    {
+        UndefinedMin = -10000,
+        CpuLose = -1000,
+        TooComplex = -1,
+        Draw = 0,
+        CpuWin = 1000,
+        UndefinedMax = 10000,
+    };
+
+    enum class PlayerEntity
+    {
+        None,
+        User,
+        Cpu,
+    };
+
+    enum class UiSign
+    {
+        None,
+        X,
+        O,
+    };
+
+    enum class Level
+    {
+        Random,
+        Easy,
+        Medium,
+        Hard,
+        Max,
+    };
+
+    struct LevelSettings
+    {
+        long long mNodeBudget;  // 0 searches on the clock only
+        int mDepthMax;          // plies below the root, 0 for no limit
+        int mBlunderPercent;    // chance of playing a random move instead
+    };
+
+    struct Position
+    {
+        Position(int x = -1, int y = -1) : mX(x), mY(y) {}
+        int mX;
+        int mY;
+    };
+
+    using Cell = PlayerEntity;
+    using Line = std::vector<Cell>;
+    using Grid = std::vector<Line>;
+
+    struct SearchInfo
+    {
+        Position mBestMove;
+        Score mScore = ScoreDefines::Draw;
+        int mDepth = 0;
+        long long mNodes = 0;
+    };
+
+    using InfoCallback = std::function<void(const SearchInfo&)>;
+
+    // score of one empty cell for the side to move, TooComplex while nothing is known;
+    // an inexact score comes from a depth limited search and may still change
+    struct CellAnalysis
+    {
+        Position mCell;
+        Score mScore = ScoreDefines::TooComplex;
+        bool mIsExact = false;
+    };
+
+    using AnalysisCallback = std::function<void(const std::vector<CellAnalysis>&, int depth)>;
+
+    // a root move of the CPU with its score and the expected continuation, mLine
+    // starts with mMove and follows the best replies found in the search cache
+    struct MoveLine
+    {
+        Position mMove;
+        Score mScore = ScoreDefines::TooComplex;
+        bool mIsExact = false;
+        std::vector<Position> mLine;
+    };
+
+    // 32 random bits per call
+    using RandomSource = std::function<uint32_t()>;
+
+public:
+    // gridSize has to be within Geometry::MinGridSize and Geometry::MaxGridSize
+    Game(Level level = Level::Max, bool isCpuFirst = false, int gridSize = 3)
+    {
+        LevelSettings settings = GetLevelSettings(level);
+        mMoves = 0;
+        mLevel = level;
+        mCpuFirst = isCpuFirst;
+        mWinner = PlayerEntity::None;
+        mTurn = isCpuFirst ? PlayerEntity::Cpu : PlayerEntity::User;
+        mTimePerMove = CpuTimePerMoveMs;
+        mNodeBudget = settings.mNodeBudget;
+        mDepthMax = settings.mDepthMax;
+        mBlunderPercent = settings.mBlunderPercent;
+        mEndgameEmpties = EndgameEmpties;
+        mProofNodes = gridSize > 3 && settings.mDepthMax == 0 ? ProofNodes : 0;
+        // no shared generator to seed from, the clock and the address differ between engines
+        mRandom.Seed(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                     reinterpret_cast<uintptr_t>(this));
+        mStop = nullptr;
+        mCache = nullptr;
+        mStats = nullptr;
+        mPatternLayout = nullptr;
+        mPatternWeights = nullptr;
+        mHash = 0;
+        mAborts = 0;
+        mIsEndgameBounded = false;
+        mIsEndgameAborted = false;
+        mGrid.clear();
+        mGrid.resize(gridSize);
+        for (auto& line : mGrid)
+            line.resize(gridSize);
+        mGeometry = &Geometry::GetTable(gridSize);
+        mLineCounts.assign(mGeometry->mLineCount, LineCount());
+        mHistory.reserve(gridSize * gridSize);
+    }
+    // the position of a code without its history, the code has to be valid
+    explicit Game(const PositionCode& code, Level level = Level::Max);
+    bool UserCanMove(Position p) const
+    {
+        return GetPlayerAtMove() == Game::PlayerEntity::User &&
+                GetWinner() == Game::PlayerEntity::None &&
+                mGrid[p.mX][p.mY] == Game::PlayerEntity::None;
+    }
+    // a new move drops the moves that could be redone
+    void SetMove(Position p)
+    {
+        mRedo.clear();
+        MakeMove(p);
+    }
+    bool CanUndo() const {return !mHistory.empty();}
+    bool CanRedo() const {return !mRedo.empty();}
+    // both return the cell of the move taken back or played again
+    Position UndoMove()
+    {
+        const Ply& ply = mHistory.back();
+        ClearCell(ply.mMove.mX, ply.mMove.mY);
+        mTurn = ply.mTurn;
+        mWinner = ply.mWinner;
+        mHash = ply.mHash;
+        mMoves--;
+
+        mRedo.push_back(ply.mMove);
+        mHistory.pop_back();
+        return mRedo.back();
+    }
+    Position RedoMove()
+    {
+        Position p = mRedo.back();
+        mRedo.pop_back();
+        MakeMove(p);
+        return p;
+    }
+    void ExecuteCpuMove(Position& p, UiSign& sign)
+    {
+        p = ComputeCpuMove();
+        SetMove(p);
+        sign = GetUiSign(p);
+    }
+    UiSign GetUiSign(Position p) const
+    {
+        PlayerEntity owner = mGrid[p.mX][p.mY];
+        return (owner == PlayerEntity::Cpu) == mCpuFirst ? UiSign::X : UiSign::O;
+    }
+    Position FindCpuMove() {return ComputeCpuMove();}
+    // the count best moves of the CPU, best first, from a single search of all root moves;
+    // a move FindCpuMove plays without a search (opening, tactics, cache, proof) comes first
+    std::vector<MoveLine> FindCpuMoves(int count);
+    // scores every empty cell for the side to move with a growing depth limit,
+    // reports after each depth and runs until all are exact or the stop flag is set
+    void Analyze(const AnalysisCallback& callback);
+    // with a node budget as well the search stops at whichever limit comes first,
+    // NoTimeLimit leaves only the node budget and with a seed makes the search reproducible
+    void SetTimePerMove(int ms) {mTimePerMove = ms;}
+    void SetNodeBudget(long long nodes) {mNodeBudget = nodes;}
+    void SetSeed(uint32_t seed) {mRandom.Seed(seed);}
+    // replaces the built-in generator, SetSeed has no effect while one is set
+    void SetRandomSource(RandomSource source) {mRandomSource = std::move(source);}
+    // positions with at most this many empty cells are solved exactly, 0 disables it
+    void SetEndgameEmpties(int empties) {mEndgameEmpties = empties;}
+    // nodes for the proof-number search looking for forced wins beyond the horizon, 0 disables it
+    void SetProofNodes(long long nodes) {mProofNodes = nodes;}
+    void SetStopFlag(const std::atomic_bool* stop) {mStop = stop;}
+    void SetInfoCallback(InfoCallback callback) {mInfoCallback = std::move(callback);}
+    void SetSearchCache(SearchCache* cache);
+    // orders the root moves by the outcomes of played games and breaks ties between
+    // equal scores with them instead of at random
+    void SetPositionStats(const PositionStats* stats) {mStats = stats;}
+    // scores the positions where the search is cut off by the learned evaluation
+    // instead of leaving them unknown, grid sizes without weights are not affected
+    void SetPatternEval(const PatternEval* eval);
+    // the score is TooComplex for a move played without a search
+    const SearchInfo& GetSearchInfo() const {return mInfo;}
+    Level GetLevel() const {return mLevel;}
+    bool IsCpuFirst() const {return mCpuFirst;}
+    PlayerEntity GetPlayerAtMove() const {return mTurn;}
+    PlayerEntity GetWinner() const {return mWinner;}
+    PlayerEntity GetCell(Position p) const {return mGrid[p.mX][p.mY];}
+    PositionCode GetPositionCode() const;
+    int GetGridSize() const {return mGrid.size();}
+
+    static LevelSettings GetLevelSettings(Level level);
+
+    // cells are written as column letter + row number, e.g. "a1" is mGrid[0][0]
+    static std::string PositionToString(Position p);
+    static Position PositionFromString(const std::string& text);
+
+private:
+    // benchmark/ times the private primitives directly
+    friend struct GameBenchmark;
+
+    bool ComputeIsOver(Position last, int moves, PlayerEntity& winner) const;
+    void MakeMove(Position p)
+    {
+        mHistory.push_back({p, mTurn, mWinner, mHash});
+        SetCell(p.mX, p.mY, mTurn);
+        mMoves++;
+        if (ComputeIsOver(p, mMoves, mWinner))
+            mTurn = PlayerEntity::None;
+        else
+            mTurn = mTurn == PlayerEntity::Cpu ? PlayerEntity::User : PlayerEntity::Cpu;
+    }
+    Position ComputeCpuMove();
+    Position ComputeRandomMove();
+    Position ComputeMinMaxBestMove();
+    // the move played without a search: a tactical answer, an exact cache entry or a proven win,
+    // the score is TooComplex when only the move is known
+    bool FindForcedMove(std::chrono::steady_clock::time_point moveStart, Position& p, Score& score);
+    Score ComputeMinMaxScore(Position lastMove, int depth, bool isCpu);
+    Score SearchRootMove(Position p, bool isCpu, bool& isExact);
+    void OrderByStats(std::vector<Position>& moves) const;
+    std::vector<Position> CollectLine(Position first, bool isCpu);
+    bool IsStopRequested() const {return mStop && mStop->load(std::memory_order_relaxed);}
+    bool IsTreeBudgetExhausted() const;
+    int GetRandom(int bound) {return Random::Bounded(mRandomSource ? mRandomSource() : mRandom.Generate(), bound);}
+    void SetCell(int i, int j, PlayerEntity player);
+    void ClearCell(int i, int j);
+    uint64_t GetNodeKey(bool isCpu) const {return isCpu ? mHash ^ CpuToMoveKey : mHash;}
+    void StoreInCache(bool isCpu, int depth, Score score, int bestCell);
+    // false when a bounded solve ran into the node budget, the clock or the stop flag
+    bool ComputeEndgameScore(int depth, bool isCpu, bool isBounded, Score& score, int& bestCell);
+    Score SolveEndgame(uint64_t cpu, uint64_t user, int* empty, int count, int depth, bool isCpu, Score alpha, Score beta,
+                       int* bestCell = nullptr);
+    bool CompletesLine(uint64_t cells, int cell) const;
+    void UpdateLineCounts(int i, int j, PlayerEntity player, int delta);
+    void UpdatePatternIndexes(int cell, PlayerEntity player, int delta);
+    Score GetPatternScore(bool isCpu) const;
+    int FindThreats(PlayerEntity player, int* cells, int maxCells) const;
+    int FindFork(PlayerEntity player) const;
+    bool FindTacticalMove(Position& p, Score& score) const;
+    int FindSymmetries(int* transforms) const;
+    bool IsOrbitRepresentative(int i, int j, const int* transforms, int count) const;
+
+    static constexpr uint64_t CpuToMoveKey = 0x9E3779B97F4A7C15ull;
+    static uint64_t CellKey(int cell, PlayerEntity player) {return Geometry::Zobrist.mKeys[player == PlayerEntity::Cpu][cell];}
+
+private:
+    Grid mGrid;
+    PlayerEntity mTurn;
+    PlayerEntity mWinner;
+    Level mLevel;
+    bool mCpuFirst;
+    int mMoves;
+
+    std::chrono::steady_clock::time_point mTreeStart;
+    int mTimePerMove;
+    int mTimePerTree;
+    int mDepthMax;
+    int mBlunderPercent;
+    int mEndgameEmpties;
+    long long mProofNodes;
+
+    const Geometry::Table* mGeometry;
+
+    // what a move changed besides its cell and line counts, undoing one is O(1)
+    struct Ply
+    {
+        Position mMove;
+        PlayerEntity mTurn;
+        PlayerEntity mWinner;
+        uint64_t mHash;
+    };
+    std::vector<Ply> mHistory;
+    std::vector<Position> mRedo;
+
+    // stones per player on each line of mGeometry, in the same order
+    struct LineCount
+    {
+        int mCpu = 0;
+        int mUser = 0;
+    };
+    std::vector<LineCount> mLineCounts;
+
+    Random mRandom;
+    RandomSource mRandomSource;
+    long long mNodeBudget;
+    long long mNodesPerTree;
+    long long mTreeStartNodes;
+
+    const std::atomic_bool* mStop;
+    InfoCallback mInfoCallback;
+    SearchInfo mInfo;
+
+    SearchCache* mCache;
+    const PositionStats* mStats;
+
+    // tuple indexes of the pattern evaluation with the CPU ([0]) or the user ([1])
+    // to move, SetCell and ClearCell keep them up to date while weights are set
+    const PatternEval::Layout* mPatternLayout;
+    const float* mPatternWeights;
+    int32_t mPatternIndexes[2][PatternEval::MaxTuples];
+
+    uint64_t mHash;
+    int mAborts;
+    bool mIsEndgameBounded;
+    bool mIsEndgameAborted;
+
+};
+
+#endif // GAME_H
@@ -0,0 +1,159 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Board geometry of every supported grid size, generated at compile time so it
+// sits in read-only data and needs no initialisation. Cells are numbered
+// row * gridSize + column, the same as the bitboards.
+namespace Geometry
+{
+    enum
+    {
+        MinGridSize = 3,
+        MaxGridSize = 8,    // the bitboards hold 64 cells
+        MaxCells = MaxGridSize * MaxGridSize,
+        MaxLines = 2 * MaxGridSize + 2,
+        MaxCellLines = 4,
+        SymmetryCount = 8,
+    };
+
+    struct Table
+    {
+        int mGridSize;
+        int mLineCount;
+        int mCenter;
+        // rows, columns, the main diagonal and the anti-diagonal, in that order
+        uint64_t mLineMasks[MaxLines];
+        uint8_t mLineCells[MaxLines][MaxGridSize];
+        // lines through each cell, as indices into mLineMasks
+        uint8_t mCellLineCount[MaxCells];
+        uint8_t mCellLines[MaxCells][MaxCellLines];
+        // image of each cell under the rotations and reflections of the square,
+        // transform 0 is the identity
+        uint8_t mSymmetry[SymmetryCount][MaxCells];
+    };
+
+    struct ZobristTable
+    {
+        uint64_t mKeys[2][MaxCells];    // [is cpu][cell]
+    };
+
+    constexpr int TransformCell(int transform, int i, int j, int gridSize)
+    {
+        int last = gridSize - 1;
+        switch (transform)
+        {
+        case 1: return j * gridSize + last - i;
+        case 2: return (last - i) * gridSize + last - j;
+        case 3: return (last - j) * gridSize + i;
+        case 4: return i * gridSize + last - j;
+        case 5: return (last - i) * gridSize + j;
+        case 6: return j * gridSize + i;
+        case 7: return (last - j) * gridSize + last - i;
+        default: return i * gridSize + j;
+        }
+    }
+
+    constexpr uint64_t ZobristKey(int cell, bool isCpu)
+    {
+        // splitmix64, the keys must stay the same between runs for the saved cache
+        uint64_t z = (static_cast<uint64_t>(cell) << 1 | isCpu) * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    constexpr void AddToLine(Table& table, int line, int position, int cell)
+    {
+        table.mLineMasks[line] |= uint64_t(1) << cell;
+        table.mLineCells[line][position] = static_cast<uint8_t>(cell);
+        table.mCellLines[cell][table.mCellLineCount[cell]++] = static_cast<uint8_t>(line);
+    }
+
+    constexpr Table MakeTable(int gridSize)
+    {
+        Table table{};
+        table.mGridSize = gridSize;
+        table.mLineCount = 2 * gridSize + 2;
+        table.mCenter = (gridSize - 1) / 2 * gridSize + (gridSize - 1) / 2;
+
+        // every line kind in turn, so the lines of a cell come in the mLineMasks order
+        for (int i = 0; i < gridSize; i++)
+            for (int k = 0; k < gridSize; k++)
+                AddToLine(table, i, k, i * gridSize + k);
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++)
+                AddToLine(table, gridSize + j, k, k * gridSize + j);
+        for (int k = 0; k < gridSize; k++)
+            AddToLine(table, 2 * gridSize, k, k * gridSize + k);
+        for (int k = 0; k < gridSize; k++)
+            AddToLine(table, 2 * gridSize + 1, k, k * gridSize + gridSize - k - 1);
+
+        for (int transform = 0; transform < SymmetryCount; transform++)
+            for (int i = 0; i < gridSize; i++)
+                for (int j = 0; j < gridSize; j++)
+                    table.mSymmetry[transform][i * gridSize + j] = static_cast<uint8_t>(TransformCell(transform, i, j, gridSize));
+
+        return table;
+    }
+
+    constexpr ZobristTable MakeZobristTable()
+    {
+        ZobristTable table{};
+        for (int cell = 0; cell < MaxCells; cell++)
+        {
+            table.mKeys[0][cell] = ZobristKey(cell, false);
+            table.mKeys[1][cell] = ZobristKey(cell, true);
+        }
+        return table;
+    }
+
+    inline constexpr Table Tables[] = {MakeTable(3), MakeTable(4), MakeTable(5), MakeTable(6), MakeTable(7), MakeTable(8)};
+    inline constexpr ZobristTable Zobrist = MakeZobristTable();
+
+    static_assert(sizeof(Tables) / sizeof(Tables[0]) == MaxGridSize - MinGridSize + 1, "one table per grid size");
+    static_assert(Tables[0].mLineMasks[0] == 0x7 && Tables[0].mLineMasks[3] == 0x49 &&
+                  Tables[0].mLineMasks[6] == 0x111 && Tables[0].mLineMasks[7] == 0x54, "3x3 lines");
+    static_assert(Tables[0].mCellLineCount[4] == 4 && Tables[0].mCellLineCount[1] == 2 && Tables[0].mCenter == 4, "3x3 cells");
+
+    constexpr bool IsSupported(int gridSize) {return gridSize >= MinGridSize && gridSize <= MaxGridSize;}
+    constexpr const Table& GetTable(int gridSize) {return Tables[gridSize - MinGridSize];}
+
+    // the number of cells set in a bitboard
+    inline int CountBits(uint64_t cells)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(cells);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(cells));
+#else
+        int count = 0;
+        for (; cells; cells &= cells - 1)
+            count++;
+        return count;
+#endif
+    }
+
+    // the lowest cell set in a bitboard, which must not be empty
+    inline int FirstBit(uint64_t cells)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(cells);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long cell;
+        _BitScanForward64(&cell, cells);
+        return static_cast<int>(cell);
+#else
+        int cell = 0;
+        for (; !(cells & 1); cells >>= 1)
+            cell++;
+        return cell;
+#endif
+    }
+}
+
+#endif // GEOMETRY_H
@@ -0,0 +1,18 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Native file mapping shared by the on-disk tables of the core.
+namespace MappedFile
+{
+    // copy-on-write mapping of the whole file, writes stay private to the process;
+    // nullptr for a missing or empty file
+    void* Map(const std::string& path, size_t& size);
+    void Unmap(void* data, size_t size);
+    // renames over an existing file, used to replace a file by a finished temporary
+    bool Replace(const std::string& from, const std::string& to);
+}
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,180 @@
+#include "patterneval.h"
+#include "trace.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static const char sMagic[4] = {'T', 'T', 'T', 'N'};
+
+static int Power3(int exponent)
+{
+    int power = 1;
+    while (exponent-- > 0)
+        power *= 3;
+    return power;
+}
+
+static PatternEval::Layout MakeLayout(int gridSize)
+{
+    PatternEval::Layout layout{};
+    layout.mGridSize = gridSize;
+
+    auto add = [&layout](int tuple, int position, int cell)
+    {
+        layout.mCellTuples[cell][layout.mCellTupleCount[cell]++] = {static_cast<uint8_t>(tuple), Power3(position)};
+    };
+
+    // the lines use the first table, the windows the one after it
+    const Geometry::Table& geometry = Geometry::GetTable(gridSize);
+    for (int line = 0; line < geometry.mLineCount; line++)
+    {
+        layout.mTupleBase[layout.mTupleCount] = 0;
+        for (int k = 0; k < gridSize; k++)
+            add(layout.mTupleCount, k, geometry.mLineCells[line][k]);
+        layout.mTupleCount++;
+    }
+
+    int windowBase = Power3(gridSize);
+    int windows = gridSize - PatternEval::WindowSize + 1;
+    for (int row = 0; row < windows; row++)
+    {
+        for (int column = 0; column < windows; column++)
+        {
+            layout.mTupleBase[layout.mTupleCount] = windowBase;
+            for (int a = 0; a < PatternEval::WindowSize; a++)
+                for (int b = 0; b < PatternEval::WindowSize; b++)
+                    add(layout.mTupleCount, a * PatternEval::WindowSize + b, (row + a) * gridSize + column + b);
+            layout.mTupleCount++;
+        }
+    }
+
+    layout.mWeightCount = windowBase + Power3(PatternEval::WindowSize * PatternEval::WindowSize);
+    return layout;
+}
+
+const PatternEval::Layout& PatternEval::GetLayout(int gridSize)
+{
+    static const Layout layouts[] =
+    {
+        MakeLayout(3), MakeLayout(4), MakeLayout(5), MakeLayout(6), MakeLayout(7), MakeLayout(8),
+    };
+    static_assert(sizeof(layouts) / sizeof(layouts[0]) == Geometry::MaxGridSize - Geometry::MinGridSize + 1,
+                  "one layout per grid size");
+    return layouts[gridSize - Geometry::MinGridSize];
+}
+
+bool PatternEval::Load(const std::string& path)
+{
+    TRACE_SCOPE("PatternEval::Load");
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    uint32_t header[2];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, sMagic, sizeof(sMagic)) != 0 ||
+            !file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != FormatVersion)
+        return false;
+
+    // nothing is replaced unless the whole file is valid
+    std::vector<float> weights[Geometry::MaxGridSize + 1];
+    for (uint32_t k = 0; k < header[1]; k++)
+    {
+        uint32_t size[2];
+        if (!file.read(reinterpret_cast<char*>(size), sizeof(size)) || !Geometry::IsSupported(size[0]) ||
+                size[1] != static_cast<uint32_t>(GetLayout(size[0]).mWeightCount))
+            return false;
+
+        weights[size[0]].resize(size[1]);
+        if (!file.read(reinterpret_cast<char*>(weights[size[0]].data()), size[1] * sizeof(float)))
+            return false;
+    }
+
+    for (int n = 0; n <= Geometry::MaxGridSize; n++)
+        mWeights[n].swap(weights[n]);
+    return true;
+}
+
+bool PatternEval::Save(const std::string& path) const
+{
+    uint32_t header[2] = {FormatVersion, 0};
+    for (const std::vector<float>& weights : mWeights)
+        header[1] += weights.empty() ? 0 : 1;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(sMagic, sizeof(sMagic));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int n = Geometry::MinGridSize; n <= Geometry::MaxGridSize; n++)
+    {
+        if (mWeights[n].empty())
+            continue;
+
+        uint32_t size[2] = {static_cast<uint32_t>(n), static_cast<uint32_t>(mWeights[n].size())};
+        file.write(reinterpret_cast<const char*>(size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(mWeights[n].data()), mWeights[n].size() * sizeof(float));
+    }
+
+    return static_cast<bool>(file.flush());
+}
+
+void PatternEval::ResetWeights(int gridSize)
+{
+    mWeights[gridSize].assign(GetLayout(gridSize).mWeightCount, 0.0f);
+}
+
+int PatternEval::GetIndexes(const PositionCode& code, int32_t* indexes)
+{
+    const Layout& layout = GetLayout(code.mGridSize);
+    for (int t = 0; t < layout.mTupleCount; t++)
+        indexes[t] = layout.mTupleBase[t];
+
+    // the same digits Game adds up move by move
+    for (int cell = 0; cell < code.mGridSize * code.mGridSize; cell++)
+    {
+        PositionCode::Cell value = code.GetCell(cell);
+        if (value == PositionCode::Empty)
+            continue;
+
+        int digit = (value == PositionCode::Cpu) == code.mIsCpuToMove ? 1 : 2;
+        for (int k = 0; k < layout.mCellTupleCount[cell]; k++)
+            indexes[layout.mCellTuples[cell][k].mTuple] += digit * layout.mCellTuples[cell][k].mPower;
+    }
+
+    return layout.mTupleCount;
+}
+
+float PatternEval::Evaluate(const PositionCode& code) const
+{
+    int32_t indexes[MaxTuples];
+    int count = GetIndexes(code, indexes);
+    return ToValue(Sum(GetWeights(code.mGridSize), indexes, count));
+}
+
+float PatternEval::Sum(const float* weights, const int32_t* indexes, int count)
+{
+    int k = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__)
+    __m256 total = _mm256_setzero_ps();
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indexes + k));
+        total = _mm256_add_ps(total, _mm256_i32gather_ps(weights, index, sizeof(float)));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, total);
+    for (float lane : lanes)
+        sum += lane;
+#endif
+    for (; k < count; k++)
+        sum += weights[indexes[k]];
+    return sum;
+}
+
+float PatternEval::ToValue(float sum)
+{
+    return std::tanh(sum);
+}
@@ -0,0 +1,82 @@
+#ifndef PATTERNEVAL_H
+#define PATTERNEVAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "geometry.h"
+#include "positioncode.h"
+
+// Learned evaluation as an n-tuple network: every line of the board and every
+// 3x3 window is a tuple, whose cells read as a base 3 number (0 empty, 1 the
+// side to move, 2 the other side) index a table of weights. All lines share
+// one table and all windows another, so a size has 3^n + 3^9 weights. The
+// value of a position is tanh of the sum over its tuples, the expected result
+// of the side to move from -1 to 1.
+//
+// Game keeps the index of every tuple up to date on each move, an evaluation
+// is then a gather over the tables (with AVX2 eight lookups at a time, qmake
+// CONFIG+=avx2). Weights come from tictactoe-train; grid sizes missing from
+// the file keep the built-in evaluation.
+//
+// The weights file is little-endian: the 4 bytes "TTTN", a 32 bit format
+// version and size count, then per size the 32 bit grid size and weight count
+// followed by the weights as 32 bit floats.
+class PatternEval
+{
+public:
+    enum
+    {
+        WindowSize = 3,
+        MaxWindows = (Geometry::MaxGridSize - WindowSize + 1) * (Geometry::MaxGridSize - WindowSize + 1),
+        MaxTuples = Geometry::MaxLines + MaxWindows,
+        MaxCellTuples = Geometry::MaxCellLines + WindowSize * WindowSize,
+    };
+
+    // a tuple through a cell and the weight of the cell in its index
+    struct CellTuple
+    {
+        uint8_t mTuple;
+        int32_t mPower;
+    };
+
+    // the tuples of one grid size, indexes include the offset of their table
+    struct Layout
+    {
+        int mGridSize;
+        int mTupleCount;
+        int mWeightCount;
+        int32_t mTupleBase[MaxTuples];
+        uint8_t mCellTupleCount[Geometry::MaxCells];
+        CellTuple mCellTuples[Geometry::MaxCells][MaxCellTuples];
+    };
+
+public:
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+    bool HasWeights(int gridSize) const {return !mWeights[gridSize].empty();}
+    const float* GetWeights(int gridSize) const {return mWeights[gridSize].data();}
+    // zero weights for a size, which then counts as present
+    void ResetWeights(int gridSize);
+    float* GetWeights(int gridSize) {return mWeights[gridSize].data();}
+
+    // writes the index of every tuple as seen by the side to move, returns the tuple count
+    static int GetIndexes(const PositionCode& code, int32_t* indexes);
+    // the value for the side to move, the size needs weights
+    float Evaluate(const PositionCode& code) const;
+
+    static const Layout& GetLayout(int gridSize);
+    static float Sum(const float* weights, const int32_t* indexes, int count);
+    static float ToValue(float sum);
+
+private:
+    enum
+    {
+        FormatVersion = 1,
+    };
+
+    std::vector<float> mWeights[Geometry::MaxGridSize + 1];
+};
+
+#endif // PATTERNEVAL_H
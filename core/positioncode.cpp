@@ -0,0 +1,161 @@
+#include "positioncode.h"
+
+#include <algorithm>
+
+static const char sCellChars[] = {'.', 'c', 'u'};
+
+static int CountCells(uint64_t word, uint64_t pattern)
+{
+    // every cell equal to pattern leaves its low bit set
+    uint64_t low = 0x5555555555555555ull;
+    uint64_t diff = word ^ pattern;
+    return Geometry::CountBits(~(diff | diff >> 1) & low);
+}
+
+PositionCode PositionCode::MakeEmpty(int gridSize, bool isCpuToMove)
+{
+    PositionCode code;
+    code.mGridSize = static_cast<uint8_t>(gridSize);
+    code.mIsCpuToMove = isCpuToMove;
+    return code;
+}
+
+PositionCode PositionCode::GetSwapped() const
+{
+    uint64_t low = 0x5555555555555555ull;
+    PositionCode code = *this;
+    code.mIsCpuToMove = !mIsCpuToMove;
+    for (uint64_t& word : code.mCells)
+        word = (word & low) << 1 | (word >> 1 & low);
+    return code;
+}
+
+bool PositionCode::IsValid() const
+{
+    if (!Geometry::IsSupported(mGridSize))
+        return false;
+
+    // no cell holds the unused value 3 and nothing lies beyond the grid
+    int cells = mGridSize * mGridSize;
+    int cpu = 0, user = 0;
+    for (int w = 0; w < 2; w++)
+    {
+        int inWord = std::max(0, std::min(32, cells - w * 32));
+        uint64_t unused = inWord == 32 ? 0 : ~0ull << (inWord * 2);
+        if ((mCells[w] & unused) || (mCells[w] & mCells[w] >> 1 & 0x5555555555555555ull))
+            return false;
+
+        cpu += CountCells(mCells[w], 0x5555555555555555ull);
+        user += CountCells(mCells[w], 0xAAAAAAAAAAAAAAAAull);
+    }
+
+    // the side to move has made as many moves as the other side or one less
+    int mover = mIsCpuToMove ? cpu : user;
+    int other = mIsCpuToMove ? user : cpu;
+    return mover == other || mover + 1 == other;
+}
+
+uint64_t PositionCode::Hash() const
+{
+    auto mix = [](uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+
+    uint64_t header = uint64_t(mGridSize) << 1 | (mIsCpuToMove ? 1 : 0);
+    return mix(mCells[0] ^ mix(mCells[1] ^ mix(header)));
+}
+
+int PositionCode::WriteText(char* text) const
+{
+    int length = 0;
+    text[length++] = static_cast<char>('0' + mGridSize);
+    text[length++] = ':';
+    for (int i = 0; i < mGridSize; i++)
+    {
+        if (i > 0)
+            text[length++] = '/';
+        for (int j = 0; j < mGridSize; j++)
+            text[length++] = sCellChars[GetCell(i * mGridSize + j)];
+    }
+    text[length++] = ':';
+    text[length++] = mIsCpuToMove ? 'c' : 'u';
+    return length;
+}
+
+std::string PositionCode::ToText() const
+{
+    char text[MaxTextSize];
+    return std::string(text, WriteText(text));
+}
+
+bool PositionCode::ParseText(const char* text, size_t length)
+{
+    if (length < 2 || text[1] != ':')
+        return false;
+
+    int gridSize = text[0] - '0';
+    if (!Geometry::IsSupported(gridSize) || length != size_t(2 + gridSize * gridSize + gridSize - 1 + 2))
+        return false;
+
+    PositionCode code = MakeEmpty(gridSize);
+    const char* p = text + 2;
+    for (int i = 0; i < gridSize; i++)
+    {
+        if (i > 0 && *p++ != '/')
+            return false;
+
+        for (int j = 0; j < gridSize; j++, p++)
+        {
+            switch (*p)
+            {
+            case '.': break;
+            case 'c': code.SetCell(i * gridSize + j, Cpu); break;
+            case 'u': code.SetCell(i * gridSize + j, User); break;
+            default: return false;
+            }
+        }
+    }
+
+    if (p[0] != ':' || (p[1] != 'c' && p[1] != 'u'))
+        return false;
+
+    code.mIsCpuToMove = p[1] == 'c';
+    if (!code.IsValid())
+        return false;
+
+    *this = code;
+    return true;
+}
+
+int PositionCode::WriteBinary(uint8_t* data) const
+{
+    int cells = mGridSize * mGridSize;
+    data[0] = mGridSize;
+    data[1] = mIsCpuToMove ? 1 : 0;
+    for (int k = 0; k < (cells + 3) / 4; k++)
+        data[2 + k] = static_cast<uint8_t>(mCells[k >> 3] >> ((k & 7) * 8));
+    return 2 + (cells + 3) / 4;
+}
+
+bool PositionCode::ReadBinary(const uint8_t* data, size_t size)
+{
+    if (size < 2 || !Geometry::IsSupported(data[0]) || data[1] > 1)
+        return false;
+
+    int cells = data[0] * data[0];
+    if (size != size_t(2 + (cells + 3) / 4))
+        return false;
+
+    PositionCode code = MakeEmpty(data[0], data[1] == 1);
+    for (int k = 0; k < (cells + 3) / 4; k++)
+        code.mCells[k >> 3] |= uint64_t(data[2 + k]) << ((k & 7) * 8);
+
+    if (!code.IsValid())
+        return false;
+
+    *this = code;
+    return true;
+}
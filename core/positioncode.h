@@ -0,0 +1,73 @@
+#ifndef POSITIONCODE_H
+#define POSITIONCODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "geometry.h"
+
+// A position packed into 2 bits per cell together with the grid size and the
+// side to move, for logs, storage and hashing. Cells are numbered row by row.
+//
+// The text form is "<size>:<rows>:<side to move>" with the rows separated by
+// '/', each cell '.' (empty), 'c' (CPU) or 'u' (user) and the side to move 'c'
+// or 'u', e.g. "3:c../.u./...:c". The binary form is the grid size, a flags
+// byte (bit 0 set when the CPU is to move) and the cells, four per byte
+// starting at the low bits.
+//
+// Finished games keep the side that would move next, which is also how the
+// side that moved first is recovered from the cell counts.
+struct PositionCode
+{
+    enum Cell
+    {
+        Empty = 0,
+        Cpu = 1,
+        User = 2,
+    };
+
+    enum
+    {
+        MaxTextSize = 2 + Geometry::MaxCells + Geometry::MaxGridSize - 1 + 2,
+        MaxBinarySize = 2 + (Geometry::MaxCells + 3) / 4,
+    };
+
+    uint8_t mGridSize = 3;
+    bool mIsCpuToMove = true;
+    uint64_t mCells[2] = {0, 0};  // cell k in bits 2k of the 128 bit pair
+
+    static PositionCode MakeEmpty(int gridSize, bool isCpuToMove = true);
+
+    Cell GetCell(int cell) const {return static_cast<Cell>(mCells[cell >> 5] >> ((cell & 31) * 2) & 3);}
+    void SetCell(int cell, Cell value)
+    {
+        uint64_t& word = mCells[cell >> 5];
+        int shift = (cell & 31) * 2;
+        word = (word & ~(uint64_t(3) << shift)) | uint64_t(value) << shift;
+    }
+
+    // the same position with the roles of CPU and user exchanged
+    PositionCode GetSwapped() const;
+    // the grid size is supported, the counts of both sides fit the side to move
+    bool IsValid() const;
+    uint64_t Hash() const;
+
+    // writes at most MaxTextSize characters without a terminator, returns the length
+    int WriteText(char* text) const;
+    std::string ToText() const;
+    bool ParseText(const char* text, size_t length);
+    bool ParseText(const std::string& text) {return ParseText(text.data(), text.size());}
+
+    // writes 2 + (cells + 3) / 4 bytes, returns the count
+    int WriteBinary(uint8_t* data) const;
+    bool ReadBinary(const uint8_t* data, size_t size);
+
+    bool operator==(const PositionCode& other) const
+    {
+        return mGridSize == other.mGridSize && mIsCpuToMove == other.mIsCpuToMove &&
+               mCells[0] == other.mCells[0] && mCells[1] == other.mCells[1];
+    }
+    bool operator!=(const PositionCode& other) const {return !(*this == other);}
+};
+
+#endif // POSITIONCODE_H
@@ -0,0 +1,153 @@
+#include "positionstats.h"
+#include "mappedfile.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static const char sMagic[4] = {'T', 'T', 'T', 'S'};
+
+static bool IsMissing(const std::string& path)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file)
+        std::fclose(file);
+    return !file && errno == ENOENT;
+}
+
+PositionStats::PositionStats()
+    : mRecords(nullptr)
+    , mCount(0)
+    , mMapping(nullptr)
+    , mMappingSize(0)
+{
+}
+
+PositionStats::~PositionStats()
+{
+    Unmap();
+}
+
+bool PositionStats::Load(const std::string& path)
+{
+    TRACE_SCOPE("PositionStats::Load");
+    size_t size = 0;
+    void* data = MappedFile::Map(path, size);
+    if (!data)
+        return false;
+
+    Header header;
+    std::memcpy(&header, data, std::min(size, sizeof(Header)));
+    if (size < sizeof(Header) || std::memcmp(header.mMagic, sMagic, sizeof(sMagic)) != 0 ||
+            header.mFormatVersion != FormatVersion || header.mRecordSize != sizeof(Record) ||
+            size != sizeof(Header) + header.mRecords * sizeof(Record))
+    {
+        MappedFile::Unmap(data, size);
+        return false;
+    }
+
+    Unmap();
+    mMapping = data;
+    mMappingSize = size;
+    mRecords = reinterpret_cast<const Record*>(static_cast<const char*>(data) + sizeof(Header));
+    mCount = header.mRecords;
+    return true;
+}
+
+bool PositionStats::Find(uint64_t key, Record& record) const
+{
+    const Record* end = mRecords + mCount;
+    const Record* found = std::lower_bound(mRecords, end, key, [](const Record& r, uint64_t k) {return r.mKey < k;});
+    if (found == end || found->mKey != key)
+        return false;
+
+    record = *found;
+    return true;
+}
+
+uint64_t PositionStats::GetKey(const PositionCode& code)
+{
+    // the side to move always plays as the CPU, then the smallest hash over the symmetries
+    PositionCode normal = code.mIsCpuToMove ? code : code.GetSwapped();
+    const Geometry::Table& geometry = Geometry::GetTable(normal.mGridSize);
+    int cells = normal.mGridSize * normal.mGridSize;
+
+    uint64_t key = normal.Hash();
+    for (int transform = 1; transform < Geometry::SymmetryCount; transform++)
+    {
+        PositionCode image = PositionCode::MakeEmpty(normal.mGridSize, true);
+        for (int cell = 0; cell < cells; cell++)
+            image.SetCell(geometry.mSymmetry[transform][cell], normal.GetCell(cell));
+        key = std::min(key, image.Hash());
+    }
+
+    return key;
+}
+
+bool PositionStats::Merge(const std::string& path, std::vector<Record> records)
+{
+    TRACE_SCOPE("PositionStats::Merge");
+    // the existing records are sorted already, a missing file starts empty and
+    // one that cannot be loaded is left alone rather than losing its counts
+    PositionStats existing;
+    if (existing.Load(path))
+        records.insert(records.end(), existing.mRecords, existing.mRecords + existing.mCount);
+    else if (!IsMissing(path))
+        return false;
+
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {return a.mKey < b.mKey;});
+    size_t count = 0;
+    for (const Record& record : records)
+    {
+        if (count > 0 && records[count - 1].mKey == record.mKey)
+        {
+            Record& merged = records[count - 1];
+            merged.mVisits += record.mVisits;
+            merged.mWins += record.mWins;
+            merged.mDraws += record.mDraws;
+            merged.mLosses += record.mLosses;
+        }
+        else
+            records[count++] = record;
+    }
+    records.resize(count);
+    existing.Unmap();
+
+    // written next to the target and renamed over it, a failed merge keeps the old file
+    std::string temporary = path + ".tmp";
+    {
+        Header header;
+        std::memset(&header, 0, sizeof(Header));
+        std::memcpy(header.mMagic, sMagic, sizeof(sMagic));
+        header.mFormatVersion = FormatVersion;
+        header.mRecordSize = sizeof(Record);
+        header.mRecords = records.size();
+
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+        if (!file.flush())
+        {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    return MappedFile::Replace(temporary, path);
+}
+
+void PositionStats::Unmap()
+{
+    if (!mMapping)
+        return;
+
+    MappedFile::Unmap(mMapping, mMappingSize);
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mRecords = nullptr;
+    mCount = 0;
+}
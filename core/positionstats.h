@@ -0,0 +1,73 @@
+#ifndef POSITIONSTATS_H
+#define POSITIONSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "positioncode.h"
+
+// Outcomes of played games per position, keyed by the canonical hash of the
+// position with the side to move: positions equal under a symmetry of the
+// board or with the roles of CPU and user exchanged share one record.
+//
+// The records are sorted by key and mapped from a file, a lookup is a binary
+// search over the read-only mapping and needs neither locks nor allocations.
+// Merge folds new counts into the file and writes it back sorted, it fails
+// without touching the file when an existing file is not a valid database.
+class PositionStats
+{
+public:
+    // wins, draws and losses of the side to move, visits also count unfinished games
+    struct Record
+    {
+        uint64_t mKey;
+        uint32_t mVisits;
+        uint32_t mWins;
+        uint32_t mDraws;
+        uint32_t mLosses;
+    };
+
+public:
+    PositionStats();
+    ~PositionStats();
+    PositionStats(const PositionStats&) = delete;
+    PositionStats& operator=(const PositionStats&) = delete;
+
+    bool Load(const std::string& path);
+    bool Find(uint64_t key, Record& record) const;
+    size_t GetSize() const {return mCount;}
+
+    static uint64_t GetKey(const PositionCode& code);
+    // adds the records, in any order and with repeated keys, to those of the file
+    // at path, which is created when missing
+    static bool Merge(const std::string& path, std::vector<Record> records);
+
+private:
+    enum
+    {
+        FormatVersion = 1,
+    };
+
+    struct Header
+    {
+        char mMagic[4];
+        uint32_t mFormatVersion;
+        uint32_t mRecordSize;
+        uint32_t mReserved0;
+        uint64_t mRecords;
+        uint64_t mReserved[5];
+    };
+
+    static_assert(sizeof(Record) == 24, "records are stored as they are in memory");
+    static_assert(sizeof(Header) == 64, "the header keeps the records aligned");
+
+    void Unmap();
+
+private:
+    const Record* mRecords;
+    size_t mCount;
+    void* mMapping;
+    size_t mMappingSize;
+};
+
+#endif // POSITIONSTATS_H
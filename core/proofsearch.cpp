@@ -0,0 +1,275 @@
+#include "proofsearch.h"
+#include "trace.h"
+
+#include <algorithm>
+
+ProofSearch::ProofSearch(size_t maxEntries)
+    : mMaxEntries(std::max<size_t>(maxEntries, 16))
+    , mGeometry(nullptr)
+    , mGridSize(0)
+    , mNodes(0)
+    , mNodeLimit(0)
+    , mCollections(0)
+    , mStop(nullptr)
+    , mHasDeadline(false)
+    , mIsAborted(false)
+    , mNextPoll(0)
+{
+}
+
+ProofSearch::Result ProofSearch::Prove(const Game& game, long long nodeLimit)
+{
+    TRACE_SCOPE("ProofSearch::Prove");
+    Result result;
+    int gridSize = game.GetGridSize();
+    if (game.GetPlayerAtMove() == Game::PlayerEntity::None)
+        return result;
+
+    // the keys only tell the attacker from the defender, so the numbers of one root
+    // mean nothing for a root of another size or with the other side attacking
+    mTable.clear();
+    mGridSize = gridSize;
+    mGeometry = &Geometry::GetTable(gridSize);
+
+    Game::PlayerEntity attacker = game.GetPlayerAtMove();
+    Node root{0, 0, 0, true, 0};
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (int j = 0; j < gridSize; j++)
+        {
+            int cell = i * gridSize + j;
+            Game::PlayerEntity owner = game.GetCell({i, j});
+            if (owner == Game::PlayerEntity::None)
+            {
+                root.mEmpty++;
+                continue;
+            }
+
+            bool isAttacker = owner == attacker;
+            (isAttacker ? root.mAttacker : root.mDefender) |= uint64_t(1) << cell;
+            root.mKey ^= CellKey(cell, isAttacker);
+        }
+    }
+
+    mNodes = 0;
+    mNodeLimit = nodeLimit;
+    mCollections = 0;
+    mIsAborted = false;
+    mNextPoll = 0;
+    Search(root, Infinity, Infinity);
+
+    Entry entry = Lookup(root);
+    result.mProof = entry.mProof;
+    result.mDisproof = entry.mDisproof;
+    result.mNodes = mNodes;
+    result.mEntries = mTable.size();
+    result.mCollections = mCollections;
+
+    // the numbers of an interrupted search are kept, the outcome is not trusted
+    if (mIsAborted)
+        return result;
+
+    if (entry.mProof == 0)
+    {
+        result.mOutcome = Outcome::Win;
+        for (int cell = 0; cell < gridSize * gridSize; cell++)
+        {
+            if ((root.mAttacker | root.mDefender) & (uint64_t(1) << cell))
+                continue;
+
+            Entry child;
+            Node next = MakeChild(root, cell, child);
+            if (child.mProof == Infinity && child.mDisproof == Infinity)
+                child = Lookup(next);
+            if (child.mProof == 0)
+            {
+                result.mBestMove = {cell / gridSize, cell % gridSize};
+                break;
+            }
+        }
+    }
+    else if (entry.mDisproof == 0)
+    {
+        result.mOutcome = Outcome::NoWin;
+    }
+
+    return result;
+}
+
+void ProofSearch::Search(const Node& node, uint32_t proofThreshold, uint32_t disproofThreshold)
+{
+    long long startNodes = mNodes++;
+    int cells = mGridSize * mGridSize;
+
+    struct Child
+    {
+        Node mNode;
+        Entry mTerminal;
+    };
+
+    std::vector<Child> children;
+    children.reserve(node.mEmpty);
+    for (int cell = 0; cell < cells; cell++)
+    {
+        if ((node.mAttacker | node.mDefender) & (uint64_t(1) << cell))
+            continue;
+
+        Child child;
+        child.mNode = MakeChild(node, cell, child.mTerminal);
+        children.push_back(child);
+    }
+
+    Entry entry = Lookup(node);
+    for (;;)
+    {
+        // OR node: proof is the smallest child proof, disproof the sum, AND node the other way round
+        uint32_t proof = node.mIsAttacker ? Infinity : 0;
+        uint32_t disproof = node.mIsAttacker ? 0 : Infinity;
+        uint32_t second = Infinity;
+        int best = -1;
+        uint32_t bestProof = 0, bestDisproof = 0;
+
+        for (int k = 0; k < static_cast<int>(children.size()); k++)
+        {
+            Entry child = children[k].mTerminal;
+            if (child.mProof == Infinity && child.mDisproof == Infinity)
+                child = Lookup(children[k].mNode);
+
+            uint32_t value = node.mIsAttacker ? child.mProof : child.mDisproof;
+            if (node.mIsAttacker)
+            {
+                disproof = Add(disproof, child.mDisproof);
+                proof = std::min(proof, child.mProof);
+            }
+            else
+            {
+                proof = Add(proof, child.mProof);
+                disproof = std::min(disproof, child.mDisproof);
+            }
+
+            if (best == -1 || value < (node.mIsAttacker ? bestProof : bestDisproof))
+            {
+                if (best != -1)
+                    second = node.mIsAttacker ? bestProof : bestDisproof;
+                best = k;
+                bestProof = child.mProof;
+                bestDisproof = child.mDisproof;
+            }
+            else
+            {
+                second = std::min(second, value);
+            }
+        }
+
+        entry.mProof = proof;
+        entry.mDisproof = disproof;
+        entry.mWork = mNodes - startNodes;
+        Store(node, entry);
+
+        if (proof >= proofThreshold || disproof >= disproofThreshold || mNodes >= mNodeLimit || IsAborted())
+            return;
+
+        uint32_t childProof, childDisproof;
+        if (node.mIsAttacker)
+        {
+            childProof = std::min(proofThreshold, Add(second, 1));
+            childDisproof = disproofThreshold - disproof + bestDisproof;
+        }
+        else
+        {
+            childProof = proofThreshold - proof + bestProof;
+            childDisproof = std::min(disproofThreshold, Add(second, 1));
+        }
+
+        Search(children[best].mNode, childProof, childDisproof);
+    }
+}
+
+bool ProofSearch::IsAborted()
+{
+    if (mIsAborted || mNodes < mNextPoll)
+        return mIsAborted;
+
+    mNextPoll = mNodes + PollNodes;
+    mIsAborted = (mStop && mStop->load(std::memory_order_relaxed)) ||
+                (mHasDeadline && std::chrono::steady_clock::now() >= mDeadline);
+    return mIsAborted;
+}
+
+ProofSearch::Entry ProofSearch::Lookup(const Node& node) const
+{
+    auto entry = mTable.find(node.mKey);
+    if (entry != mTable.end())
+        return entry->second;
+
+    return {1, 1, 0};
+}
+
+void ProofSearch::Store(const Node& node, const Entry& entry)
+{
+    auto stored = mTable.find(node.mKey);
+    if (stored != mTable.end())
+    {
+        stored->second = entry;
+        return;
+    }
+
+    // collect before inserting so the entry just computed survives
+    if (mTable.size() >= mMaxEntries)
+        CollectGarbage();
+    mTable.emplace(node.mKey, entry);
+}
+
+ProofSearch::Node ProofSearch::MakeChild(const Node& node, int cell, Entry& terminal) const
+{
+    Node child = node;
+    uint64_t bit = uint64_t(1) << cell;
+    uint64_t& mover = node.mIsAttacker ? child.mAttacker : child.mDefender;
+    mover |= bit;
+    child.mKey ^= CellKey(cell, node.mIsAttacker);
+    child.mIsAttacker = !node.mIsAttacker;
+    child.mEmpty--;
+
+    // Infinity in both marks a position that is not over yet
+    terminal = {Infinity, Infinity, 0};
+    if (CompletesLine(mover, cell))
+        terminal = node.mIsAttacker ? Entry{0, Infinity, 0} : Entry{Infinity, 0, 0};
+    else if (child.mEmpty == 0)
+        terminal = {Infinity, 0, 0};
+
+    return child;
+}
+
+bool ProofSearch::CompletesLine(uint64_t cells, int cell) const
+{
+    for (int k = 0; k < mGeometry->mCellLineCount[cell]; k++)
+    {
+        uint64_t line = mGeometry->mLineMasks[mGeometry->mCellLines[cell][k]];
+        if ((cells & line) == line)
+            return true;
+    }
+    return false;
+}
+
+void ProofSearch::CollectGarbage()
+{
+    // keep the half of the table that took the most work to compute
+    std::vector<long long> work;
+    work.reserve(mTable.size());
+    for (auto& entry : mTable)
+        work.push_back(entry.second.mWork);
+
+    auto median = work.begin() + work.size() / 2;
+    std::nth_element(work.begin(), median, work.end());
+    long long threshold = *median;
+
+    for (auto entry = mTable.begin(); entry != mTable.end();)
+    {
+        if (entry->second.mWork <= threshold && mTable.size() > mMaxEntries / 2)
+            entry = mTable.erase(entry);
+        else
+            ++entry;
+    }
+
+    mCollections++;
+}
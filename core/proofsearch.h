@@ -0,0 +1,96 @@
+#ifndef PROOFSEARCH_H
+#define PROOFSEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include "game.h"
+
+// Depth-first proof-number search (df-pn) proving whether the side to move
+// can force a win. The node table is bounded, when it fills up the entries
+// with the least work behind them are dropped. A stop flag or a deadline, polled
+// every PollNodes nodes, ends the search early with an unknown outcome. Each
+// Prove starts from an empty table, so one instance can serve any roots.
+class ProofSearch
+{
+public:
+    enum
+    {
+        DefaultMaxEntries = 1 << 20,
+        PollNodes = 1024,
+    };
+
+    static constexpr uint32_t Infinity = 1u << 30;
+
+    enum class Outcome
+    {
+        Unknown,
+        Win,
+        NoWin,  // a draw or a loss
+    };
+
+    struct Result
+    {
+        Outcome mOutcome = Outcome::Unknown;
+        uint32_t mProof = 1;
+        uint32_t mDisproof = 1;
+        long long mNodes = 0;
+        size_t mEntries = 0;
+        int mCollections = 0;
+        Game::Position mBestMove;
+    };
+
+public:
+    ProofSearch(size_t maxEntries = DefaultMaxEntries);
+
+    Result Prove(const Game& game, long long nodeLimit);
+    void SetStopFlag(const std::atomic_bool* stop) {mStop = stop;}
+    void SetDeadline(std::chrono::steady_clock::time_point deadline) {mDeadline = deadline; mHasDeadline = true;}
+
+private:
+    struct Entry
+    {
+        uint32_t mProof;
+        uint32_t mDisproof;
+        long long mWork;
+    };
+
+    struct Node
+    {
+        uint64_t mAttacker;
+        uint64_t mDefender;
+        uint64_t mKey;
+        bool mIsAttacker;   // attacker to move, an OR node
+        int mEmpty;
+    };
+
+    void Search(const Node& node, uint32_t proofThreshold, uint32_t disproofThreshold);
+    Entry Lookup(const Node& node) const;
+    void Store(const Node& node, const Entry& entry);
+    Node MakeChild(const Node& node, int cell, Entry& terminal) const;
+    bool CompletesLine(uint64_t cells, int cell) const;
+    void CollectGarbage();
+    bool IsAborted();
+
+    static uint32_t Add(uint32_t a, uint32_t b) {return a + b >= Infinity ? Infinity : a + b;}
+    // the side to move follows from the stones, so it needs no key
+    static uint64_t CellKey(int cell, bool isAttacker) {return Geometry::Zobrist.mKeys[isAttacker][cell];}
+
+private:
+    size_t mMaxEntries;
+    std::unordered_map<uint64_t, Entry> mTable;
+    const Geometry::Table* mGeometry;
+    int mGridSize;
+    long long mNodes;
+    long long mNodeLimit;
+    int mCollections;
+
+    const std::atomic_bool* mStop;
+    std::chrono::steady_clock::time_point mDeadline;
+    bool mHasDeadline;
+    bool mIsAborted;
+    long long mNextPoll;
+};
+
+#endif // PROOFSEARCH_H
@@ -0,0 +1,29 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Seedable splitmix64 generator, each engine owns its own so nothing is shared
+// between engines running side by side.
+class Random
+{
+public:
+    explicit Random(uint64_t seed = 0) : mState(seed) {}
+
+    void Seed(uint64_t seed) {mState = seed;}
+    uint32_t Generate()
+    {
+        uint64_t z = (mState += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+
+    // maps 32 random bits to [0, bound)
+    static int Bounded(uint32_t value, int bound) {return static_cast<int>((static_cast<uint64_t>(value) * bound) >> 32);}
+
+private:
+    uint64_t mState;
+};
+
+#endif // RANDOM_H
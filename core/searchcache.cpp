@@ -0,0 +1,179 @@
+#include "searchcache.h"
+#include "mappedfile.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static const char sMagic[4] = {'T', 'T', 'T', 'C'};
+
+// data word: score 0-15, depth 16-23, bound 24-31, best move 32-39, generation 40-47
+static int16_t GetScore(uint64_t data) {return static_cast<int16_t>(data & 0xFFFF);}
+static uint8_t GetDepth(uint64_t data) {return static_cast<uint8_t>(data >> 16);}
+static uint8_t GetBound(uint64_t data) {return static_cast<uint8_t>(data >> 24);}
+static uint8_t GetBestMove(uint64_t data) {return static_cast<uint8_t>(data >> 32);}
+static uint8_t GetGeneration(uint64_t data) {return static_cast<uint8_t>(data >> 40);}
+
+SearchCache::SearchCache(int gridSize, int engineVersion, size_t megabytes)
+    : mGridSize(gridSize)
+    , mEngineVersion(engineVersion)
+    , mBucketCount(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Bucket), 1))
+    , mGeneration(0)
+    , mOwned(new Bucket[mBucketCount]())
+    , mMapping(nullptr)
+    , mMappingSize(0)
+{
+    mBuckets = mOwned.get();
+}
+
+SearchCache::~SearchCache()
+{
+    Unmap();
+}
+
+bool SearchCache::Probe(uint64_t key, Entry& entry) const
+{
+    const Bucket* bucket = GetBucket(key);
+    for (auto& slot : bucket->mSlots)
+    {
+        uint64_t data = slot.mData.load(std::memory_order_relaxed);
+        uint64_t check = slot.mCheck.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || GetBound(data) == None)
+            continue;
+
+        entry.mKey = key;
+        entry.mScore = GetScore(data);
+        entry.mDepth = GetDepth(data);
+        entry.mBound = GetBound(data);
+        entry.mBestMove = GetBestMove(data);
+        return true;
+    }
+
+    return false;
+}
+
+void SearchCache::Store(uint64_t key, int score, int depth, Bound bound, int bestMove)
+{
+    // the same position is overwritten in place, otherwise the slot with the least
+    // depth goes, where every generation of age counts as two plies less
+    uint8_t generation = mGeneration.load(std::memory_order_relaxed);
+    Bucket* bucket = GetBucket(key);
+    Slot* victim = nullptr;
+    int victimValue = 0;
+
+    for (auto& slot : bucket->mSlots)
+    {
+        uint64_t data = slot.mData.load(std::memory_order_relaxed);
+        uint64_t check = slot.mCheck.load(std::memory_order_relaxed);
+        if ((check ^ data) == key || GetBound(data) == None)
+        {
+            victim = &slot;
+            break;
+        }
+
+        int age = static_cast<uint8_t>(generation - GetGeneration(data));
+        int value = GetDepth(data) - 2 * age;
+        if (!victim || value < victimValue)
+        {
+            victim = &slot;
+            victimValue = value;
+        }
+    }
+
+    uint64_t data = Pack(score, depth, bound, bestMove, generation);
+    victim->mCheck.store(key ^ data, std::memory_order_relaxed);
+    victim->mData.store(data, std::memory_order_relaxed);
+}
+
+bool SearchCache::Load(const std::string& path)
+{
+    TRACE_SCOPE("SearchCache::Load");
+    size_t size = 0;
+    void* data = MappedFile::Map(path, size);
+    if (!data)
+        return false;
+
+    Header header;
+    std::memcpy(&header, data, std::min(size, sizeof(Header)));
+    Header expected = MakeHeader();
+    expected.mBuckets = header.mBuckets;
+
+    if (size < sizeof(Header) || std::memcmp(&header, &expected, sizeof(Header)) != 0 || header.mBuckets == 0 ||
+            size != sizeof(Header) + header.mBuckets * sizeof(Bucket))
+    {
+        MappedFile::Unmap(data, size);
+        return false;
+    }
+
+    Unmap();
+    mMapping = data;
+    mMappingSize = size;
+    mBuckets = reinterpret_cast<Bucket*>(static_cast<char*>(data) + sizeof(Header));
+    mBucketCount = header.mBuckets;
+    mOwned.reset();
+    return true;
+}
+
+bool SearchCache::Save(const std::string& path)
+{
+    TRACE_SCOPE("SearchCache::Save");
+    // the mapping has to go before the file can be replaced
+    if (mMapping)
+    {
+        mOwned.reset(new Bucket[mBucketCount]);
+        std::memcpy(static_cast<void*>(mOwned.get()), mBuckets, mBucketCount * sizeof(Bucket));
+        mBuckets = mOwned.get();
+        Unmap();
+    }
+
+    // written next to the target and renamed over it, a failed save keeps the old file
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        Header header = MakeHeader();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(mBuckets), mBucketCount * sizeof(Bucket));
+        if (!file.flush())
+        {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    return MappedFile::Replace(temporary, path);
+}
+
+void SearchCache::Unmap()
+{
+    if (!mMapping)
+        return;
+
+    MappedFile::Unmap(mMapping, mMappingSize);
+    mMapping = nullptr;
+    mMappingSize = 0;
+}
+
+SearchCache::Header SearchCache::MakeHeader() const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.mMagic, sMagic, sizeof(sMagic));
+    header.mFormatVersion = FormatVersion;
+    header.mEngineVersion = mEngineVersion;
+    header.mGridSize = mGridSize;
+    header.mBuckets = mBucketCount;
+    header.mBucketSize = sizeof(Bucket);
+    return header;
+}
+
+uint64_t SearchCache::Pack(int score, int depth, Bound bound, int bestMove, uint8_t generation)
+{
+    return static_cast<uint64_t>(static_cast<uint16_t>(score)) |
+            static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 16 |
+            static_cast<uint64_t>(bound) << 24 |
+            static_cast<uint64_t>(static_cast<uint8_t>(bestMove)) << 32 |
+            static_cast<uint64_t>(generation) << 40;
+}
@@ -0,0 +1,121 @@
+#ifndef SEARCHCACHE_H
+#define SEARCHCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Position cache of the search, hash -> score/bound/depth/best move.
+// It can be saved to disk and mapped back in on the next start.
+//
+// Any number of threads may probe and store at once without locking. Each slot
+// keeps its key XORed with its data, a slot torn by two racing writers no
+// longer matches its key and reads as a miss.
+class SearchCache
+{
+public:
+    enum
+    {
+        DefaultMegabytes = 16,
+        NoMove = 0xFF,
+        CacheLineSize = 64,
+    };
+
+    enum Bound : uint8_t
+    {
+        None,
+        Exact,
+        Lower,
+        Upper,
+    };
+
+    struct Entry
+    {
+        uint64_t mKey = 0;
+        int16_t mScore = 0;
+        uint8_t mDepth = 0;
+        uint8_t mBound = None;
+        uint8_t mBestMove = NoMove;
+    };
+
+public:
+    SearchCache(int gridSize, int engineVersion, size_t megabytes = DefaultMegabytes);
+    ~SearchCache();
+    SearchCache(const SearchCache&) = delete;
+    SearchCache& operator=(const SearchCache&) = delete;
+
+    bool Probe(uint64_t key, Entry& entry) const;
+    void Store(uint64_t key, int score, int depth, Bound bound, int bestMove);
+    // ages the entries of earlier searches so they are replaced first
+    void NewSearch() {mGeneration.fetch_add(1, std::memory_order_relaxed);}
+    void Prefetch(uint64_t key) const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(GetBucket(key));
+#else
+        (void)key;
+#endif
+    }
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path);
+
+    int GetGridSize() const {return mGridSize;}
+    size_t GetSize() const {return mBucketCount * BucketSlots;}
+
+private:
+    enum
+    {
+        FormatVersion = 2,
+        BucketSlots = 4,
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> mCheck;  // key ^ data
+        std::atomic<uint64_t> mData;
+    };
+
+    // one bucket per cache line, a probe touches a single line
+    struct alignas(CacheLineSize) Bucket
+    {
+        Slot mSlots[BucketSlots];
+    };
+
+    // padded to a cache line so mapped buckets stay aligned
+    struct Header
+    {
+        char mMagic[4];
+        uint32_t mFormatVersion;
+        uint32_t mEngineVersion;
+        uint32_t mGridSize;
+        uint64_t mBuckets;
+        uint32_t mBucketSize;
+        uint32_t mReserved[9];
+    };
+
+    static_assert(sizeof(Bucket) == CacheLineSize, "a bucket must fill one cache line");
+    static_assert(sizeof(Header) == CacheLineSize, "the header must keep the buckets aligned");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots need lock-free 64 bit atomics");
+
+    Header MakeHeader() const;
+    void Unmap();
+    Bucket* GetBucket(uint64_t key) const {return mBuckets + key % mBucketCount;}
+
+    static uint64_t Pack(int score, int depth, Bound bound, int bestMove, uint8_t generation);
+
+private:
+    int mGridSize;
+    int mEngineVersion;
+    size_t mBucketCount;
+    std::atomic<uint8_t> mGeneration;
+
+    // either points into mOwned or into the mapped file
+    Bucket* mBuckets;
+    std::unique_ptr<Bucket[]> mOwned;
+    void* mMapping;
+    size_t mMappingSize;
+};
+
+#endif // SEARCHCACHE_H
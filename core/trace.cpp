@@ -0,0 +1,101 @@
+#include "trace.h"
+
+#ifdef TICTACTOE_TRACE
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace
+{
+    namespace
+    {
+        // buffers live until exit so a dump can still read threads that have finished,
+        // a finished thread's buffer goes to the next new thread, which appends to
+        // its events, so there are only as many as threads ever ran at once
+        std::mutex gBuffersMutex;
+        std::vector<std::unique_ptr<Buffer>> gBuffers;
+
+        Buffer* AcquireBuffer()
+        {
+            std::lock_guard<std::mutex> lock(gBuffersMutex);
+            for (auto& buffer : gBuffers)
+            {
+                if (!buffer->mIsInUse)
+                {
+                    buffer->mIsInUse = true;
+                    return buffer.get();
+                }
+            }
+
+            gBuffers.emplace_back(new Buffer());
+            gBuffers.back()->mThreadId = static_cast<int>(gBuffers.size());
+            gBuffers.back()->mIsInUse = true;
+            return gBuffers.back().get();
+        }
+
+        struct ThreadBuffer
+        {
+            Buffer* mBuffer = AcquireBuffer();
+
+            ~ThreadBuffer()
+            {
+                std::lock_guard<std::mutex> lock(gBuffersMutex);
+                mBuffer->mIsInUse = false;
+            }
+        };
+
+        void WriteEscaped(std::ostream& out, const char* text)
+        {
+            for (; *text; text++)
+            {
+                if (*text == '"' || *text == '\\')
+                    out << '\\';
+                out << *text;
+            }
+        }
+    }
+
+    Buffer& GetThreadBuffer()
+    {
+        thread_local ThreadBuffer buffer;
+        return *buffer.mBuffer;
+    }
+
+    bool Dump(const std::string& path)
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+
+        out << "{\"traceEvents\":[";
+        bool first = true;
+
+        std::lock_guard<std::mutex> lock(gBuffersMutex);
+        for (auto& buffer : gBuffers)
+        {
+            // events still being written past the head are skipped, older ones may
+            // be overwritten while dumping a busy thread, which only garbles those
+            uint64_t head = buffer->mHead.load(std::memory_order_acquire);
+            uint64_t begin = head > BufferEvents ? head - BufferEvents : 0;
+            for (uint64_t i = begin; i < head; i++)
+            {
+                const Event& event = buffer->mEvents[i % BufferEvents];
+                out << (first ? "\n" : ",\n") << "{\"name\":\"";
+                WriteEscaped(out, event.mName);
+                out << "\",\"pid\":1,\"tid\":" << buffer->mThreadId << ",\"ts\":" << event.mStartUs;
+                if (event.mDurationUs < 0)
+                    out << ",\"ph\":\"i\",\"s\":\"t\"}";
+                else
+                    out << ",\"ph\":\"X\",\"dur\":" << event.mDurationUs << "}";
+                first = false;
+            }
+        }
+
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+}
+
+#endif
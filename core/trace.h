@@ -0,0 +1,96 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped trace markers dumped as Chrome trace-event JSON (chrome://tracing,
+// Perfetto). Tracing is compiled in with "qmake CONFIG+=trace", otherwise the
+// markers expand to nothing.
+//
+//  TRACE_SCOPE("name");    complete event from here to the end of the scope
+//  TRACE_INSTANT("name");  single point in time
+//
+// Names must be string literals, only the pointer is stored.
+
+#include <string>
+
+#ifdef TICTACTOE_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Trace
+{
+    enum
+    {
+        BufferEvents = 1 << 16,  // per thread, the oldest events are overwritten
+    };
+
+    struct Event
+    {
+        const char* mName;
+        int64_t mStartUs;
+        int64_t mDurationUs;  // -1 for an instant event
+    };
+
+    // written by its own thread only, the dump reads up to the published head;
+    // when the thread exits the next new thread takes the buffer over
+    struct Buffer
+    {
+        Event mEvents[BufferEvents];
+        std::atomic<uint64_t> mHead{0};
+        int mThreadId = 0;
+        bool mIsInUse = false;  // guarded by the list of buffers
+    };
+
+    Buffer& GetThreadBuffer();
+
+    inline int64_t NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline void Record(const char* name, int64_t startUs, int64_t durationUs)
+    {
+        Buffer& buffer = GetThreadBuffer();
+        uint64_t head = buffer.mHead.load(std::memory_order_relaxed);
+        buffer.mEvents[head % BufferEvents] = {name, startUs, durationUs};
+        buffer.mHead.store(head + 1, std::memory_order_release);
+    }
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : mName(name), mStartUs(NowUs()) {}
+        ~Scope() {Record(mName, mStartUs, NowUs() - mStartUs);}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* mName;
+        int64_t mStartUs;
+    };
+
+    // writes the events of all threads, returns false when the file cannot be written
+    bool Dump(const std::string& path);
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_INSTANT(name) Trace::Record(name, Trace::NowUs(), -1)
+
+#else
+
+namespace Trace
+{
+    inline bool Dump(const std::string&) {return false;}
+}
+
+#define TRACE_SCOPE(name) do {} while (false)
+#define TRACE_INSTANT(name) do {} while (false)
+
+#endif
+
+#endif // TRACE_H
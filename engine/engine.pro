@@ -0,0 +1,16 @@
+CONFIG -= qt
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-engine
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
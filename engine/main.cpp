@@ -0,0 +1,405 @@
+// Headless engine speaking a line protocol on stdin/stdout.
+//
+//  tictactoe                          -> id name ..., tictactoeok
+//  isready                            -> readyok
+//  newgame [size <n>] [level <0-4>] [easy] [seed <s>]
+//                                     start a new game, size 3 and level 4
+//                                     (max) by default, easy is level 0
+//  position [code <code>] [moves <m1> <m2> ...]
+//                                     moves from the empty board or from a
+//                                     position code (positioncode.h), e.g.
+//                                     "b2 a1"; a code also sets the grid size
+//  code                               -> code <position code>, with the side to
+//                                     move as the CPU
+//  go [movetime <ms>] [nodes <n>] [multipv <k>]
+//                                     search for the side to move until either
+//                                     limit is reached, a node budget without
+//                                     movetime makes the search reproducible
+//  stop                               finish the current search now
+//  prove [nodes <n>] [entries <n>]    proof-number search whether the side to
+//                                     move forces a win, blocks until done
+//  trace <file>                       write the Chrome trace recorded so far,
+//                                     needs a build with CONFIG+=trace
+//  quit
+//
+// While searching the engine prints "info depth <d> nodes <n> score <s> pv <m>"
+// and ends with "bestmove <m>" ("bestmove none" when the game is over).
+// Scores are from the point of view of the side to move. With multipv the k
+// best moves are reported before bestmove as "info multipv <i> score <s>
+// <exact|bound> pv <m1> <m2> ...", best first; a bound score comes from a
+// search that was cut short.
+//
+// A proof ends with "proof <win|nowin|unknown> pn <p> dn <d> nodes <n>
+// entries <e> gc <c> move <m>", where pn and dn are the proof and disproof
+// numbers left at the root and move is the winning move or "none".
+//
+// Started with --cache <dir> the engine maps its search cache from
+// <dir>/cache-<size>.bin and saves it back on exit. --cache-size <mb> sets the
+// size of new caches, 16 MB by default. --stats <file> loads a position
+// statistics database (tictactoe-stats) for move ordering and tie-breaks.
+// --eval <file> loads pattern evaluation weights (tictactoe-train), which score
+// the positions where the search is cut off; without them, or for grid sizes
+// they do not cover, those positions stay unknown (score -1).
+
+#include "game.h"
+#include "searchcache.h"
+#include "patterneval.h"
+#include "positionstats.h"
+#include "proofsearch.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <mutex>
+#include <thread>
+
+class Engine
+{
+    enum
+    {
+        DefaultProofNodes = 10000000,
+    };
+
+public:
+    Engine(const std::string& cacheDirectory, size_t cacheMegabytes, const PositionStats* stats, const PatternEval* eval)
+        : mCacheDirectory(cacheDirectory)
+        , mCacheMegabytes(cacheMegabytes)
+        , mStats(stats)
+        , mEval(eval)
+    {
+    }
+
+    ~Engine()
+    {
+        Stop();
+
+        if (!mCacheDirectory.empty())
+            for (auto& cache : mCaches)
+                cache.second->Save(GetCachePath(cache.first));
+    }
+
+    bool Execute(const std::string& line)
+    {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "tictactoe")
+        {
+            Send("id name TicTacToe");
+            Send("tictactoeok");
+        }
+        else if (command == "isready")
+            Send("readyok");
+        else if (command == "newgame")
+            NewGame(in);
+        else if (command == "position")
+            SetPosition(in);
+        else if (command == "go")
+            Go(in);
+        else if (command == "stop")
+            Stop();
+        else if (command == "code")
+            Send("code " + MakeGame(mMoves).GetPositionCode().ToText());
+        else if (command == "prove")
+            Prove(in);
+        else if (command == "trace")
+        {
+            std::string path;
+            in >> path;
+            if (!Trace::Dump(path))
+                Send("info string cannot write trace " + path);
+        }
+        else if (command == "quit")
+            return false;
+        else if (!command.empty())
+            Send("info string unknown command " + command);
+
+        return true;
+    }
+
+private:
+    void NewGame(std::istringstream& in)
+    {
+        Stop();
+        mGridSize = 3;
+        mLevel = Game::Level::Max;
+        mHasSeed = false;
+        mMoves.clear();
+
+        std::string token;
+        while (in >> token)
+        {
+            if (token == "size")
+                in >> mGridSize;
+            else if (token == "easy")
+                mLevel = Game::Level::Random;
+            else if (token == "level")
+            {
+                int level = static_cast<int>(Game::Level::Max);
+                in >> level;
+                mLevel = static_cast<Game::Level>(std::max(0, std::min(level, static_cast<int>(Game::Level::Max))));
+            }
+            else if (token == "seed")
+                mHasSeed = static_cast<bool>(in >> mSeed);
+        }
+
+        if (!Geometry::IsSupported(mGridSize))
+        {
+            Send("info string unsupported size " + std::to_string(mGridSize));
+            mGridSize = 3;
+        }
+        mStart = PositionCode::MakeEmpty(mGridSize);
+    }
+
+    void SetPosition(std::istringstream& in)
+    {
+        Stop();
+        mMoves.clear();
+
+        mStart = PositionCode::MakeEmpty(mGridSize);
+
+        std::string token;
+        in >> token;
+        if (token == "code")
+        {
+            std::string text;
+            in >> text;
+            PositionCode code;
+            if (!code.ParseText(text))
+            {
+                Send("info string illegal code " + text);
+                return;
+            }
+
+            // kept with the CPU to move, MakeGame swaps the sides for an odd number of moves
+            mStart = code.mIsCpuToMove ? code : code.GetSwapped();
+            mGridSize = mStart.mGridSize;
+            token.clear();
+            in >> token;
+        }
+
+        if (token != "moves")
+            return;
+
+        Game game = MakeGame({});
+        while (in >> token)
+        {
+            Game::Position p = Game::PositionFromString(token);
+            if (p.mX < 0 || p.mX >= mGridSize || p.mY < 0 || p.mY >= mGridSize ||
+                    game.GetPlayerAtMove() == Game::PlayerEntity::None || game.GetCell(p) != Game::PlayerEntity::None)
+            {
+                Send("info string illegal move " + token);
+                break;
+            }
+            game.SetMove(p);
+            mMoves.push_back(p);
+        }
+    }
+
+    void Go(std::istringstream& in)
+    {
+        TRACE_SCOPE("Engine::Go");
+        Stop();
+
+        int moveTime = 0;
+        long long nodes = 0;
+        int multiPv = 1;
+        std::string token;
+        while (in >> token)
+        {
+            if (token == "movetime")
+                in >> moveTime;
+            else if (token == "nodes")
+                in >> nodes;
+            else if (token == "multipv")
+                in >> multiPv;
+        }
+
+        SearchCache* cache = GetSearchCache(mGridSize);
+        mStop = false;
+        mSearch = std::thread([this, moveTime, nodes, multiPv, cache]()
+        {
+            // the side to move plays as the CPU
+            Game game = MakeGame(mMoves);
+            if (game.GetPlayerAtMove() == Game::PlayerEntity::None)
+            {
+                Send("bestmove none");
+                return;
+            }
+
+            // a node budget alone is not timed, so that it is reproducible
+            game.SetTimePerMove(moveTime > 0 ? moveTime : nodes > 0 ? Game::NoTimeLimit : Game::CpuTimePerMoveMs);
+            if (nodes > 0)
+                game.SetNodeBudget(nodes);
+            if (mHasSeed)
+                game.SetSeed(mSeed);
+            game.SetStopFlag(&mStop);
+            game.SetSearchCache(cache);
+            game.SetPositionStats(mStats);
+            game.SetPatternEval(mEval);
+            game.SetInfoCallback([this](const Game::SearchInfo& info)
+            {
+                Send("info depth " + std::to_string(info.mDepth) +
+                     " nodes " + std::to_string(info.mNodes) +
+                     " score " + std::to_string(info.mScore) +
+                     " pv " + Game::PositionToString(info.mBestMove));
+            });
+
+            if (multiPv <= 1)
+            {
+                Game::Position p = game.FindCpuMove();
+                Send("bestmove " + Game::PositionToString(p));
+                return;
+            }
+
+            std::vector<Game::MoveLine> moves = game.FindCpuMoves(multiPv);
+            for (size_t i = 0; i < moves.size(); i++)
+            {
+                std::string line = "info multipv " + std::to_string(i + 1) +
+                                   " score " + std::to_string(moves[i].mScore) +
+                                   (moves[i].mIsExact ? " exact" : " bound") + " pv";
+                for (auto& p : moves[i].mLine)
+                    line += " " + Game::PositionToString(p);
+                Send(line);
+            }
+            Send("bestmove " + Game::PositionToString(moves.front().mMove));
+        });
+    }
+
+    void Prove(std::istringstream& in)
+    {
+        Stop();
+
+        long long nodes = DefaultProofNodes;
+        size_t entries = ProofSearch::DefaultMaxEntries;
+        std::string token;
+        while (in >> token)
+        {
+            if (token == "nodes")
+                in >> nodes;
+            else if (token == "entries")
+                in >> entries;
+        }
+
+        Game game = MakeGame(mMoves);
+        ProofSearch search(entries);
+        ProofSearch::Result result = search.Prove(game, nodes);
+
+        const char* outcome = result.mOutcome == ProofSearch::Outcome::Win ? "win" :
+                              result.mOutcome == ProofSearch::Outcome::NoWin ? "nowin" : "unknown";
+        Send(std::string("proof ") + outcome +
+             " pn " + std::to_string(result.mProof) +
+             " dn " + std::to_string(result.mDisproof) +
+             " nodes " + std::to_string(result.mNodes) +
+             " entries " + std::to_string(result.mEntries) +
+             " gc " + std::to_string(result.mCollections) +
+             " move " + Game::PositionToString(result.mBestMove));
+    }
+
+    void Stop()
+    {
+        mStop = true;
+        if (mSearch.joinable())
+            mSearch.join();
+    }
+
+    Game MakeGame(const std::vector<Game::Position>& moves) const
+    {
+        // the side to move after the moves plays as the CPU
+        Game game(moves.size() % 2 == 0 ? mStart : mStart.GetSwapped(), mLevel);
+        for (auto& p : moves)
+            game.SetMove(p);
+        return game;
+    }
+
+    SearchCache* GetSearchCache(int gridSize)
+    {
+        auto& cache = mCaches[gridSize];
+        if (!cache)
+        {
+            cache.reset(new SearchCache(gridSize, Game::EngineVersion, mCacheMegabytes));
+            if (!mCacheDirectory.empty())
+                cache->Load(GetCachePath(gridSize));
+        }
+
+        return cache.get();
+    }
+
+    std::string GetCachePath(int gridSize) const
+    {
+        return mCacheDirectory + "/cache-" + std::to_string(gridSize) + ".bin";
+    }
+
+    void Send(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(mOutputMutex);
+        std::cout << line << std::endl;
+    }
+
+private:
+    int mGridSize = 3;
+    Game::Level mLevel = Game::Level::Max;
+    bool mHasSeed = false;
+    uint32_t mSeed = 0;
+    PositionCode mStart = PositionCode::MakeEmpty(3);
+    std::vector<Game::Position> mMoves;
+
+    std::string mCacheDirectory;
+    size_t mCacheMegabytes;
+    std::map<int, std::unique_ptr<SearchCache>> mCaches;
+    const PositionStats* mStats;
+    const PatternEval* mEval;
+
+    std::thread mSearch;
+    std::atomic_bool mStop{false};
+    std::mutex mOutputMutex;
+};
+
+int main(int argc, char *argv[])
+{
+    std::ios::sync_with_stdio(false);
+
+    std::string cacheDirectory;
+    size_t cacheMegabytes = SearchCache::DefaultMegabytes;
+    PositionStats stats;
+    bool hasStats = false;
+    PatternEval eval;
+    bool hasEval = false;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--cache")
+            cacheDirectory = argv[++i];
+        else if (arg == "--cache-size")
+            cacheMegabytes = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--stats")
+        {
+            hasStats = stats.Load(argv[++i]);
+            if (!hasStats)
+                std::cerr << "cannot load " << argv[i] << std::endl;
+        }
+        else if (arg == "--eval")
+        {
+            hasEval = eval.Load(argv[++i]);
+            if (!hasEval)
+                std::cerr << "cannot load " << argv[i] << std::endl;
+        }
+    }
+
+    Engine engine(cacheDirectory, cacheMegabytes, hasStats ? &stats : nullptr, hasEval ? &eval : nullptr);
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!engine.Execute(line))
+            break;
+    }
+
+    return 0;
+}
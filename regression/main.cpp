@@ -0,0 +1,333 @@
+// Runs the golden positions through a deterministic search (fixed seed and
+// node budget) and checks the chosen move, its score and the node count.
+//
+//  tictactoe-regression [golden.txt] [--tolerance <percent>] [--record]
+//  tictactoe-regression --stress-cache [seconds]
+//
+// Each line of the golden file is
+//  <size> <moves> <node budget> <seed> <best move> <score> <nodes>
+// where moves are comma separated from the empty board, "-" for none.
+// --record rewrites the file with the current results.
+//
+// Every run first compares the compile-time geometry tables (geometry.h) with
+// the same tables computed here at runtime, any mismatch fails the run.
+//
+// --stress-cache stores and probes a small shared search cache from every core
+// at once, with each entry derived from its key, and fails if a probe ever
+// returns an entry that does not belong to its key.
+
+#include "game.h"
+#include "searchcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+struct GoldenPosition
+{
+    int mGridSize = 3;
+    std::string mMoves;
+    long long mBudget = 0;
+    uint32_t mSeed = 0;
+    std::string mBestMove;
+    Game::Score mScore = 0;
+    long long mNodes = 0;
+};
+
+static bool ParsePosition(const std::string& line, GoldenPosition& position)
+{
+    std::istringstream in(line);
+    return static_cast<bool>(in >> position.mGridSize >> position.mMoves >> position.mBudget >> position.mSeed
+                             >> position.mBestMove >> position.mScore >> position.mNodes);
+}
+
+static std::string FormatPosition(const GoldenPosition& position)
+{
+    std::ostringstream out;
+    out << position.mGridSize << ' ' << position.mMoves << ' ' << position.mBudget << ' ' << position.mSeed
+        << ' ' << position.mBestMove << ' ' << position.mScore << ' ' << position.mNodes;
+    return out.str();
+}
+
+static bool MakeGame(const GoldenPosition& position, Game& game)
+{
+    std::vector<Game::Position> moves;
+    std::istringstream in(position.mMoves == "-" ? std::string() : position.mMoves);
+    std::string move;
+    while (std::getline(in, move, ','))
+        moves.push_back(Game::PositionFromString(move));
+
+    if (!Geometry::IsSupported(position.mGridSize))
+        return false;
+
+    // the side to move plays as the CPU, a move off the grid or onto a taken cell makes the line invalid
+    game = Game(Game::Level::Max, moves.size() % 2 == 0, position.mGridSize);
+    for (auto& p : moves)
+    {
+        if (p.mX < 0 || p.mX >= position.mGridSize || p.mY < 0 || p.mY >= position.mGridSize ||
+                game.GetPlayerAtMove() == Game::PlayerEntity::None || game.GetCell(p) != Game::PlayerEntity::None)
+            return false;
+        game.SetMove(p);
+    }
+
+    return game.GetPlayerAtMove() == Game::PlayerEntity::Cpu;
+}
+
+static int CheckGeometry()
+{
+    int mismatches = 0;
+    auto check = [&mismatches](bool condition, int gridSize, const char* what)
+    {
+        if (!condition)
+        {
+            std::cout << "GEOMETRY " << gridSize << "x" << gridSize << " " << what << " differs" << std::endl;
+            mismatches++;
+        }
+    };
+
+    for (int n = Geometry::MinGridSize; n <= Geometry::MaxGridSize; n++)
+    {
+        const Geometry::Table& table = Geometry::GetTable(n);
+        check(table.mGridSize == n && table.mLineCount == 2 * n + 2, n, "size");
+        check(table.mCenter == (n - 1) / 2 * (n + 1), n, "center");
+
+        // reference lines in table order: rows, columns, main and anti-diagonal
+        std::vector<std::vector<int>> lines(2 * n + 2);
+        for (int i = 0; i < n; i++)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                lines[i].push_back(i * n + k);
+                lines[n + i].push_back(k * n + i);
+            }
+            lines[2 * n].push_back(i * n + i);
+            lines[2 * n + 1].push_back(i * n + n - 1 - i);
+        }
+
+        for (int line = 0; line < 2 * n + 2; line++)
+        {
+            uint64_t mask = 0;
+            for (int k = 0; k < n; k++)
+            {
+                mask |= uint64_t(1) << lines[line][k];
+                check(table.mLineCells[line][k] == lines[line][k], n, "line cells");
+            }
+            check(table.mLineMasks[line] == mask, n, "line mask");
+        }
+
+        for (int cell = 0; cell < n * n; cell++)
+        {
+            std::vector<int> through;
+            for (int line = 0; line < 2 * n + 2; line++)
+                if (std::find(lines[line].begin(), lines[line].end(), cell) != lines[line].end())
+                    through.push_back(line);
+
+            bool same = table.mCellLineCount[cell] == static_cast<int>(through.size());
+            for (size_t k = 0; same && k < through.size(); k++)
+                same = table.mCellLines[cell][k] == through[k];
+            check(same, n, "cell lines");
+        }
+
+        // the eight symmetries as rotations by 90 degrees, each with and without a mirror
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                std::vector<int> images;
+                int x = i, y = j;
+                for (int rotation = 0; rotation < 4; rotation++)
+                {
+                    images.push_back(x * n + y);
+                    images.push_back(x * n + n - 1 - y);
+                    int next = y;
+                    y = n - 1 - x;
+                    x = next;
+                }
+
+                std::vector<int> actual;
+                for (int transform = 0; transform < Geometry::SymmetryCount; transform++)
+                    actual.push_back(table.mSymmetry[transform][i * n + j]);
+
+                check(actual[0] == i * n + j, n, "identity");
+                std::sort(images.begin(), images.end());
+                std::sort(actual.begin(), actual.end());
+                check(images == actual, n, "symmetries");
+            }
+        }
+    }
+
+    for (int cell = 0; cell < Geometry::MaxCells; cell++)
+    {
+        for (int isCpu = 0; isCpu < 2; isCpu++)
+        {
+            uint64_t z = (static_cast<uint64_t>(cell) << 1 | isCpu) * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            check(Geometry::Zobrist.mKeys[isCpu][cell] == (z ^ (z >> 31)), Geometry::MaxGridSize, "zobrist key");
+        }
+    }
+
+    return mismatches;
+}
+
+static SearchCache::Entry MakeStressEntry(uint64_t key)
+{
+    SearchCache::Entry entry;
+    entry.mKey = key;
+    entry.mScore = static_cast<int16_t>(key >> 48);
+    entry.mDepth = static_cast<uint8_t>(key >> 40);
+    entry.mBound = static_cast<uint8_t>(SearchCache::Exact + (key >> 32) % 3);
+    entry.mBestMove = static_cast<uint8_t>(key >> 24);
+    return entry;
+}
+
+static int StressCache(int seconds)
+{
+    // a 1 MB table and a key space a few times larger keep the buckets contended
+    SearchCache cache(3, Game::EngineVersion, 1);
+    const uint64_t keySpace = cache.GetSize() * 4;
+    int threads = std::max(2u, std::thread::hardware_concurrency());
+
+    std::atomic_bool stop(false);
+    std::atomic<long long> stores(0), probes(0), hits(0), torn(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            Random random(t + 1);
+            long long localStores = 0, localProbes = 0, localHits = 0, localTorn = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                // spread the key bits so the derived fields differ between keys
+                uint64_t key = (random.Generate() % keySpace + 1) * 0x9E3779B97F4A7C15ull;
+                if (random.Generate() & 1)
+                {
+                    SearchCache::Entry entry = MakeStressEntry(key);
+                    cache.Store(key, entry.mScore, entry.mDepth, static_cast<SearchCache::Bound>(entry.mBound), entry.mBestMove);
+                    localStores++;
+                    if (localStores % 1024 == 0)
+                        cache.NewSearch();
+                    continue;
+                }
+
+                SearchCache::Entry found;
+                localProbes++;
+                if (!cache.Probe(key, found))
+                    continue;
+
+                SearchCache::Entry expected = MakeStressEntry(key);
+                localHits++;
+                if (found.mScore != expected.mScore || found.mDepth != expected.mDepth ||
+                        found.mBound != expected.mBound || found.mBestMove != expected.mBestMove)
+                    localTorn++;
+            }
+
+            stores += localStores;
+            probes += localProbes;
+            hits += localHits;
+            torn += localTorn;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto& worker : workers)
+        worker.join();
+
+    std::cout << threads << " threads, " << stores << " stores, " << probes << " probes, " << hits << " hits, "
+              << torn << " torn" << std::endl;
+    return torn ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = "golden.txt";
+    double tolerance = 5.0;
+    bool record = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--record")
+            record = true;
+        else if (arg == "--stress-cache")
+            return StressCache(i + 1 < argc ? std::max(1, std::atoi(argv[++i])) : 10);
+        else if (arg == "--tolerance" && i + 1 < argc)
+            tolerance = std::atof(argv[++i]);
+        else
+            path = arg;
+    }
+
+    std::ifstream input(path);
+    if (!input)
+    {
+        std::cerr << "Could not open " << path << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> output;
+    int failures = CheckGeometry();
+    int count = 0;
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        GoldenPosition expected;
+        if (line.empty() || line[0] == '#' || !ParsePosition(line, expected))
+        {
+            output.push_back(line);
+            continue;
+        }
+
+        Game game;
+        if (!MakeGame(expected, game))
+        {
+            std::cout << "INVALID " << line << std::endl;
+            output.push_back(line);
+            failures++;
+            continue;
+        }
+
+        game.SetNodeBudget(expected.mBudget);
+        game.SetTimePerMove(Game::NoTimeLimit);
+        game.SetSeed(expected.mSeed);
+
+        auto start = std::chrono::steady_clock::now();
+        Game::Position p = game.FindCpuMove();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        GoldenPosition actual = expected;
+        actual.mBestMove = Game::PositionToString(p);
+        actual.mScore = game.GetSearchInfo().mScore;
+        actual.mNodes = game.GetSearchInfo().mNodes;
+        output.push_back(FormatPosition(actual));
+        count++;
+
+        double drift = expected.mNodes ? 100.0 * (actual.mNodes - expected.mNodes) / expected.mNodes : 0.0;
+        bool passed = actual.mBestMove == expected.mBestMove && actual.mScore == expected.mScore &&
+                std::abs(drift) <= tolerance;
+        if (!passed && !record)
+            failures++;
+
+        std::cout << (record ? "RECORD " : passed ? "PASS " : "FAIL ") << FormatPosition(actual)
+                  << " (expected " << expected.mBestMove << ' ' << expected.mScore << ' ' << expected.mNodes
+                  << ", nodes " << (drift >= 0 ? "+" : "") << drift << "%, " << elapsed << " ms)" << std::endl;
+    }
+
+    input.close();
+    if (record)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        for (auto& outputLine : output)
+            file << outputLine << '\n';
+    }
+
+    std::cout << count << " positions, " << failures << " failed" << std::endl;
+    return failures ? 1 : 0;
+}
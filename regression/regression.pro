@@ -0,0 +1,14 @@
+CONFIG -= qt
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-regression
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
+
+DISTFILES += \
+    golden.txt
@@ -0,0 +1,429 @@
+// Plays the engine against itself on every core and streams the positions it
+// searched, labelled with the search score and the final result, for training
+// evaluation functions offline.
+//
+//  tictactoe-selfplay --output <file> [--config <config>] [--games <n>]
+//                     [--sizes <n,n,...>] [--opening-plies <n>] [--seed <s>]
+//                     [--threads <n>] [--sample <fraction>] [--dedup]
+//                     [--batch <kb>]
+//
+// The config holds the search settings (core/engineconfig.h). Every game starts
+// with --opening-plies random moves, which are not recorded, on the grid sizes
+// in turn (3 to 8 by default). --sample keeps each position with the given
+// probability, --dedup writes a position only the first time it or one of its
+// symmetric images comes up.
+//
+// The file is the 4 bytes "TTTD", a 32 bit format version and then one record
+// per position, all little-endian:
+//  the binary position code (core/positioncode.h) with the side to move as the
+//  CPU, 2 + (cells + 3) / 4 bytes starting with the grid size
+//  int16 search score of the move played for the side to move, -1 when unknown
+//  int8 final result for the side to move, 1 win, 0 draw, -1 loss
+//
+// Workers fill a buffer of --batch KB (256 by default) each and hand it to a
+// writer thread, so the search never waits for the disk.
+
+#include "engineconfig.h"
+#include "game.h"
+#include "patterneval.h"
+#include "positionstats.h"
+#include "random.h"
+#include "searchcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+enum
+{
+    FormatVersion = 1,
+    DefaultGames = 1000,
+    DefaultOpeningPlies = 2,
+    DefaultBatchKb = 256,
+    MaxQueuedBatches = 16,
+    DedupShards = 64,
+};
+
+static const char sMagic[4] = {'T', 'T', 'T', 'D'};
+
+struct Options
+{
+    EngineConfig mConfig;
+    std::string mOutput;
+    int mGames = DefaultGames;
+    std::vector<int> mSizes;
+    int mOpeningPlies = DefaultOpeningPlies;
+    uint32_t mSeed = 1;
+    int mThreads = 0;
+    double mSample = 1.0;
+    bool mDedup = false;
+    size_t mBatchBytes = DefaultBatchKb * 1024;
+};
+
+static bool ParseSizes(const std::string& text, std::vector<int>& sizes)
+{
+    sizes.clear();
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        int size = std::atoi(item.c_str());
+        if (!Geometry::IsSupported(size))
+            return false;
+        sizes.push_back(size);
+    }
+
+    return !sizes.empty();
+}
+
+// Writes the batches of the workers in the order they arrive. Workers only
+// wait when the disk falls MaxQueuedBatches behind.
+class BatchWriter
+{
+public:
+    BatchWriter()
+        : mBytes(0)
+        , mIsDone(false)
+        , mIsFailed(false)
+    {
+    }
+
+    bool Open(const std::string& path)
+    {
+        mFile.open(path, std::ios::binary | std::ios::trunc);
+        uint32_t version = FormatVersion;
+        uint8_t header[8] = {uint8_t(sMagic[0]), uint8_t(sMagic[1]), uint8_t(sMagic[2]), uint8_t(sMagic[3]),
+                             uint8_t(version), uint8_t(version >> 8), uint8_t(version >> 16), uint8_t(version >> 24)};
+        mFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (!mFile)
+            return false;
+
+        mBytes = sizeof(header);
+        mThread = std::thread(&BatchWriter::WriterLoop, this);
+        return true;
+    }
+
+    void Push(std::vector<uint8_t>&& batch)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSpace.wait(lock, [this]() {return mQueue.size() < MaxQueuedBatches;});
+        mQueue.push_back(std::move(batch));
+        mWork.notify_one();
+    }
+
+    // writes what is queued and closes the file
+    bool Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsDone = true;
+        }
+        mWork.notify_one();
+        mThread.join();
+
+        mFile.close();
+        return !mIsFailed && !mFile.fail();
+    }
+
+    long long GetBytes() const {return mBytes;}
+
+private:
+    void WriterLoop()
+    {
+        for (;;)
+        {
+            std::vector<uint8_t> batch;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWork.wait(lock, [this]() {return mIsDone || !mQueue.empty();});
+                if (mQueue.empty())
+                    return;
+
+                batch = std::move(mQueue.front());
+                mQueue.pop_front();
+            }
+            mSpace.notify_one();
+
+            mFile.write(reinterpret_cast<const char*>(batch.data()), batch.size());
+            mIsFailed = mIsFailed || !mFile;
+            mBytes += batch.size();
+        }
+    }
+
+private:
+    std::ofstream mFile;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mWork;
+    std::condition_variable mSpace;
+    std::deque<std::vector<uint8_t>> mQueue;
+    std::atomic<long long> mBytes;
+    bool mIsDone;
+    bool mIsFailed;
+};
+
+class SelfPlay
+{
+public:
+    explicit SelfPlay(const Options& options)
+        : mOptions(options)
+        , mNextGame(0)
+        , mPositions(0)
+        , mSampledOut(0)
+        , mDuplicates(0)
+    {
+        for (int size : mOptions.mSizes)
+            if (!mCaches[size])
+                mCaches[size].reset(new SearchCache(size, Game::EngineVersion, mOptions.mConfig.mCacheMegabytes));
+    }
+
+    bool Run()
+    {
+        if (!mOptions.mConfig.mStatsPath.empty())
+        {
+            mStats.reset(new PositionStats());
+            if (!mStats->Load(mOptions.mConfig.mStatsPath))
+            {
+                std::cerr << "cannot load " << mOptions.mConfig.mStatsPath << std::endl;
+                return false;
+            }
+        }
+
+        if (!mOptions.mConfig.mEvalPath.empty())
+        {
+            mEval.reset(new PatternEval());
+            if (!mEval->Load(mOptions.mConfig.mEvalPath))
+            {
+                std::cerr << "cannot load " << mOptions.mConfig.mEvalPath << std::endl;
+                return false;
+            }
+        }
+
+        if (!mWriter.Open(mOptions.mOutput))
+        {
+            std::cerr << "cannot write " << mOptions.mOutput << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int threads = mOptions.mThreads > 0 ? mOptions.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back(&SelfPlay::WorkerLoop, this, i);
+        for (auto& worker : workers)
+            worker.join();
+
+        bool isWritten = mWriter.Finish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long written = mPositions - mSampledOut - mDuplicates;
+        std::cout << mOptions.mGames << " games, " << mPositions << " positions, " << written << " written, "
+                  << mSampledOut << " sampled out, " << mDuplicates << " duplicates, " << mWriter.GetBytes()
+                  << " bytes, " << static_cast<long long>(mPositions / std::max(seconds, 1e-9)) << " positions/s"
+                  << std::endl;
+
+        if (!isWritten)
+            std::cerr << "cannot write " << mOptions.mOutput << std::endl;
+        return isWritten;
+    }
+
+private:
+    struct Searched
+    {
+        PositionCode mCode;
+        int mScore;
+    };
+
+    struct DedupShard
+    {
+        std::mutex mMutex;
+        std::unordered_set<uint64_t> mKeys;
+    };
+
+    void WorkerLoop(int worker)
+    {
+        Random sampler(static_cast<uint64_t>(mOptions.mSeed) << 32 ^ static_cast<uint64_t>(worker) * 0x9E3779B97F4A7C15ull);
+        uint32_t threshold = static_cast<uint32_t>(std::min(1.0, mOptions.mSample) * 4294967295.0);
+
+        std::vector<uint8_t> batch;
+        batch.reserve(mOptions.mBatchBytes + PositionCode::MaxBinarySize + 3);
+        std::vector<Searched> searched;
+
+        for (;;)
+        {
+            int index = mNextGame++;
+            if (index >= mOptions.mGames)
+                break;
+
+            Game::PlayerEntity winner = PlayGame(index, searched);
+            for (const Searched& position : searched)
+            {
+                mPositions++;
+                if (mOptions.mSample < 1.0 && sampler.Generate() > threshold)
+                {
+                    mSampledOut++;
+                    continue;
+                }
+
+                if (mOptions.mDedup && !IsFirstSeen(PositionStats::GetKey(position.mCode)))
+                {
+                    mDuplicates++;
+                    continue;
+                }
+
+                // positions are stored with the side to move as the CPU
+                int result = winner == Game::PlayerEntity::None ? 0 : winner == Game::PlayerEntity::Cpu ? 1 : -1;
+                if (!position.mCode.mIsCpuToMove)
+                    result = -result;
+
+                uint8_t record[PositionCode::MaxBinarySize + 3];
+                PositionCode code = position.mCode.mIsCpuToMove ? position.mCode : position.mCode.GetSwapped();
+                int size = code.WriteBinary(record);
+                record[size++] = static_cast<uint8_t>(position.mScore & 0xFF);
+                record[size++] = static_cast<uint8_t>((position.mScore >> 8) & 0xFF);
+                record[size++] = static_cast<uint8_t>(static_cast<int8_t>(result));
+                batch.insert(batch.end(), record, record + size);
+            }
+
+            if (batch.size() >= mOptions.mBatchBytes)
+            {
+                mWriter.Push(std::move(batch));
+                batch = std::vector<uint8_t>();
+                batch.reserve(mOptions.mBatchBytes + PositionCode::MaxBinarySize + 3);
+            }
+        }
+
+        if (!batch.empty())
+            mWriter.Push(std::move(batch));
+    }
+
+    // the positions after the opening with the score of the search that moved from them,
+    // coded as seen by the first game, whose CPU moves first
+    Game::PlayerEntity PlayGame(int index, std::vector<Searched>& searched)
+    {
+        int gridSize = mOptions.mSizes[index % mOptions.mSizes.size()];
+        Game games[2] =
+        {
+            MakeGame(gridSize, true, 2 * index),
+            MakeGame(gridSize, false, 2 * index + 1),
+        };
+
+        Random random(static_cast<uint64_t>(mOptions.mSeed) << 32 | static_cast<uint32_t>(index));
+        int cells = gridSize * gridSize;
+        for (int ply = 0; ply < mOptions.mOpeningPlies && ply < cells - 1; ply++)
+        {
+            std::vector<Game::Position> empty;
+            for (int cell = 0; cell < cells; cell++)
+            {
+                Game::Position p(cell / gridSize, cell % gridSize);
+                if (games[0].GetCell(p) == Game::PlayerEntity::None)
+                    empty.push_back(p);
+            }
+
+            Game::Position p = empty[Random::Bounded(random.Generate(), (int)empty.size())];
+            games[0].SetMove(p);
+            games[1].SetMove(p);
+            if (games[0].GetPlayerAtMove() == Game::PlayerEntity::None)
+                break;
+        }
+
+        searched.clear();
+        while (games[0].GetPlayerAtMove() != Game::PlayerEntity::None)
+        {
+            Game& mover = games[0].GetPlayerAtMove() == Game::PlayerEntity::Cpu ? games[0] : games[1];
+            Game::Position p = mover.FindCpuMove();
+            searched.push_back({games[0].GetPositionCode(), mover.GetSearchInfo().mScore});
+            games[0].SetMove(p);
+            games[1].SetMove(p);
+        }
+
+        return games[0].GetWinner();
+    }
+
+    Game MakeGame(int gridSize, bool isCpuFirst, int seed)
+    {
+        Game game = mOptions.mConfig.MakeGame(isCpuFirst, gridSize);
+        game.SetSeed(mOptions.mSeed + seed);
+        game.SetSearchCache(mCaches[gridSize].get());
+        game.SetPositionStats(mStats.get());
+        game.SetPatternEval(mEval.get());
+        return game;
+    }
+
+    bool IsFirstSeen(uint64_t key)
+    {
+        DedupShard& shard = mDedup[key % DedupShards];
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        return shard.mKeys.insert(key).second;
+    }
+
+private:
+    const Options& mOptions;
+    std::map<int, std::unique_ptr<SearchCache>> mCaches;
+    std::unique_ptr<PositionStats> mStats;
+    std::unique_ptr<PatternEval> mEval;
+    BatchWriter mWriter;
+    DedupShard mDedup[DedupShards];
+
+    std::atomic_int mNextGame;
+    std::atomic<long long> mPositions;
+    std::atomic<long long> mSampledOut;
+    std::atomic<long long> mDuplicates;
+};
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int n = Geometry::MinGridSize; n <= Geometry::MaxGridSize; n++)
+        options.mSizes.push_back(n);
+
+    bool isValid = true;
+    for (int i = 1; i < argc && isValid; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc)
+            options.mOutput = argv[++i];
+        else if (arg == "--config" && i + 1 < argc)
+            isValid = options.mConfig.Parse(argv[++i]);
+        else if (arg == "--games" && i + 1 < argc)
+            options.mGames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sizes" && i + 1 < argc)
+            isValid = ParseSizes(argv[++i], options.mSizes);
+        else if (arg == "--opening-plies" && i + 1 < argc)
+            options.mOpeningPlies = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            options.mSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && i + 1 < argc)
+            options.mThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sample" && i + 1 < argc)
+            options.mSample = std::atof(argv[++i]);
+        else if (arg == "--dedup")
+            options.mDedup = true;
+        else if (arg == "--batch" && i + 1 < argc)
+            options.mBatchBytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) * 1024;
+        else
+            isValid = false;
+    }
+
+    if (!isValid || options.mOutput.empty() || options.mSample <= 0.0)
+    {
+        std::cerr << "usage: tictactoe-selfplay --output <file> [--config <config>] [--games <n>] [--sizes <n,n,...>]\n"
+                     "                          [--opening-plies <n>] [--seed <s>] [--threads <n>]\n"
+                     "                          [--sample <fraction>] [--dedup] [--batch <kb>]\n"
+                     "config: " << EngineConfig::GetUsage() << std::endl;
+        return 2;
+    }
+
+    SelfPlay selfPlay(options);
+    return selfPlay.Run() ? 0 : 1;
+}
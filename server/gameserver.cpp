@@ -0,0 +1,295 @@
+#include "gameserver.h"
+#include "trace.h"
+
+#include <algorithm>
+
+GameServer::GameServer(int workers, int moveDeadlineMs, ResultCallback callback)
+    : mActiveSessions(0)
+    , mQueueDepth(0)
+    , mLatencyIndex(0)
+    , mMoves(0)
+    , mMoveDeadlineMs(moveDeadlineMs)
+    , mCallback(std::move(callback))
+    , mShutdown(false)
+{
+    mLatencies.reserve(LatencySamples);
+
+    for (int i = 0; i < std::max(1, workers); i++)
+        mWorkers.emplace_back(&GameServer::WorkerLoop, this);
+}
+
+GameServer::~GameServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mWork.notify_all();
+
+    for (auto& worker : mWorkers)
+        worker.join();
+}
+
+GameServer::SessionId GameServer::CreateSession(ClientId client, int gridSize, Game::Level level, bool isCpuFirst)
+{
+    if (gridSize < 3 || gridSize > MaxGridSize)
+        return InvalidSession;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    SessionId id;
+    if (!mFreeSessions.empty())
+    {
+        id = mFreeSessions.back();
+        mFreeSessions.pop_back();
+    }
+    else
+    {
+        id = static_cast<SessionId>(mSessions.size());
+        mSessions.emplace_back();
+    }
+
+    Session& session = mSessions[id];
+    session = Session();
+    session.mClient = client;
+    session.mGridSize = static_cast<uint8_t>(gridSize);
+    session.mFlags = isCpuFirst ? CpuFirst : 0;
+    session.mLevel = static_cast<uint8_t>(level);
+    mActiveSessions++;
+
+    if (isCpuFirst)
+        Schedule(id);
+
+    return id;
+}
+
+bool GameServer::PlayUserMove(ClientId client, SessionId id, Game::Position p)
+{
+    MoveResult result;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (id >= mSessions.size())
+            return false;
+
+        Session& session = mSessions[id];
+        int gridSize = session.mGridSize;
+        if (gridSize == 0 || session.mClient != client || (session.mFlags & (Pending | Over | Closed)))
+            return false;
+
+        if (p.mX < 0 || p.mX >= gridSize || p.mY < 0 || p.mY >= gridSize)
+            return false;
+
+        uint64_t bit = uint64_t(1) << (p.mX * gridSize + p.mY);
+        if ((session.mUserCells | session.mCpuCells) & bit)
+            return false;
+
+        session.mUserCells |= bit;
+
+        uint64_t occupied = session.mUserCells | session.mCpuCells;
+        bool isFull = occupied == (uint64_t(1) << (gridSize * gridSize)) - 1;
+        bool userWon = HasLine(session.mUserCells, gridSize);
+        if (!userWon && !isFull)
+        {
+            Schedule(id);
+            return true;
+        }
+
+        session.mFlags |= Over;
+        result = {session.mClient, id, Game::Position(), true, userWon ? Game::PlayerEntity::User : Game::PlayerEntity::None};
+    }
+
+    mCallback(result);
+    return true;
+}
+
+bool GameServer::CloseSession(ClientId client, SessionId id)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (id >= mSessions.size() || mSessions[id].mGridSize == 0 || mSessions[id].mClient != client ||
+            (mSessions[id].mFlags & Closed))
+        return false;
+
+    Release(id);
+    return true;
+}
+
+void GameServer::CloseClient(ClientId client)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (SessionId id = 0; id < mSessions.size(); id++)
+        if (mSessions[id].mGridSize != 0 && mSessions[id].mClient == client)
+            Release(id);
+}
+
+GameServer::Stats GameServer::GetStats() const
+{
+    Stats stats;
+    std::vector<int> latencies;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats.mSessions = mActiveSessions;
+        stats.mQueueDepth = mQueueDepth;
+        stats.mMoves = mMoves;
+        latencies = mLatencies;
+    }
+
+    if (!latencies.empty())
+    {
+        auto percentile = [&latencies](int pct)
+        {
+            auto nth = latencies.begin() + (latencies.size() - 1) * pct / 100;
+            std::nth_element(latencies.begin(), nth, latencies.end());
+            return *nth;
+        };
+        stats.mP50Ms = percentile(50);
+        stats.mP99Ms = percentile(99);
+    }
+
+    return stats;
+}
+
+void GameServer::Schedule(SessionId id)
+{
+    Session& session = mSessions[id];
+    session.mFlags |= Pending;
+
+    auto& queue = mClientQueues[session.mClient];
+    if (queue.empty())
+        mReadyClients.push_back(session.mClient);
+
+    queue.push_back({id, Clock::now()});
+    mQueueDepth++;
+    mWork.notify_one();
+}
+
+void GameServer::Release(SessionId id)
+{
+    Session& session = mSessions[id];
+
+    // a worker owns pending sessions, it frees the slot once the move is done
+    if (session.mFlags & Pending)
+    {
+        session.mFlags |= Closed;
+        return;
+    }
+
+    session = Session();
+    mFreeSessions.push_back(id);
+    mActiveSessions--;
+}
+
+void GameServer::WorkerLoop()
+{
+    for (;;)
+    {
+        Job job;
+        Session session;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWork.wait(lock, [this]() {return mShutdown || !mReadyClients.empty();});
+            if (mShutdown)
+                return;
+
+            ClientId client = mReadyClients.front();
+            mReadyClients.pop_front();
+
+            auto queue = mClientQueues.find(client);
+            job = queue->second.front();
+            queue->second.pop_front();
+            if (queue->second.empty())
+                mClientQueues.erase(queue);
+            else
+                mReadyClients.push_back(client);
+
+            mQueueDepth--;
+            session = mSessions[job.mSession];
+        }
+
+        MoveResult result{session.mClient, job.mSession, Game::Position(), false, Game::PlayerEntity::None};
+
+        if (!(session.mFlags & Closed))
+        {
+            TRACE_SCOPE("GameServer::ComputeMove");
+            // whatever time the job spent queued is taken from its search budget
+            auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - job.mQueued).count();
+            int budget = mMoveDeadlineMs - static_cast<int>(waited);
+
+            Game::Level level = budget < MinSearchMs ? Game::Level::Random : static_cast<Game::Level>(session.mLevel);
+            Game game = MakeGame(session, level);
+            game.SetTimePerMove(budget);
+            result.mMove = game.FindCpuMove();
+            game.SetMove(result.mMove);
+            result.mIsOver = game.GetPlayerAtMove() == Game::PlayerEntity::None;
+            result.mWinner = game.GetWinner();
+        }
+
+        int latency = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - job.mQueued).count());
+        bool deliver = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            Session& stored = mSessions[job.mSession];
+            stored.mFlags &= ~Pending;
+            if (stored.mFlags & Closed)
+            {
+                Release(job.mSession);
+            }
+            else
+            {
+                stored.mCpuCells |= uint64_t(1) << (result.mMove.mX * stored.mGridSize + result.mMove.mY);
+                if (result.mIsOver)
+                    stored.mFlags |= Over;
+                deliver = true;
+            }
+
+            mMoves++;
+            RecordLatency(latency);
+        }
+
+        if (deliver)
+            mCallback(result);
+    }
+}
+
+void GameServer::RecordLatency(int ms)
+{
+    if (mLatencies.size() < LatencySamples)
+        mLatencies.push_back(ms);
+    else
+        mLatencies[mLatencyIndex] = ms;
+
+    mLatencyIndex = (mLatencyIndex + 1) % LatencySamples;
+}
+
+Game GameServer::MakeGame(const Session& session, Game::Level level)
+{
+    int gridSize = session.mGridSize;
+    Game game(level, session.mFlags & CpuFirst, gridSize);
+
+    // any interleaving of the stored cells reaches the same position as long as
+    // turns alternate, and the game cannot end early since it is not over yet
+    uint64_t user = session.mUserCells;
+    uint64_t cpu = session.mCpuCells;
+    while (user | cpu)
+    {
+        uint64_t& cells = game.GetPlayerAtMove() == Game::PlayerEntity::Cpu ? cpu : user;
+        int cell = Geometry::FirstBit(cells);
+        cells &= cells - 1;
+        game.SetMove({cell / gridSize, cell % gridSize});
+    }
+
+    return game;
+}
+
+bool GameServer::HasLine(uint64_t cells, int gridSize)
+{
+    const Geometry::Table& geometry = Geometry::GetTable(gridSize);
+    for (int line = 0; line < geometry.mLineCount; line++)
+        if ((cells & geometry.mLineMasks[line]) == geometry.mLineMasks[line])
+            return true;
+
+    return false;
+}
@@ -0,0 +1,117 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include "game.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Hosts many games at once. Sessions are kept as two cell bitmasks and only
+// expanded into a Game while a worker computes the CPU move for them.
+class GameServer
+{
+public:
+    using SessionId = uint32_t;
+    using ClientId = uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr SessionId InvalidSession = 0xFFFFFFFF;
+
+    enum
+    {
+        MaxGridSize = 7,
+        LatencySamples = 4096,
+        MinSearchMs = 10,
+    };
+
+    struct MoveResult
+    {
+        ClientId mClient;
+        SessionId mSession;
+        Game::Position mMove;   // CPU move, mX == -1 when reporting the user move
+        bool mIsOver;
+        Game::PlayerEntity mWinner;
+    };
+
+    struct Stats
+    {
+        size_t mSessions = 0;
+        size_t mQueueDepth = 0;
+        long long mMoves = 0;
+        int mP50Ms = 0;
+        int mP99Ms = 0;
+    };
+
+    using ResultCallback = std::function<void(const MoveResult&)>;
+
+public:
+    GameServer(int workers, int moveDeadlineMs, ResultCallback callback);
+    ~GameServer();
+
+    SessionId CreateSession(ClientId client, int gridSize, Game::Level level, bool isCpuFirst);
+    // both fail for a session of another client
+    bool PlayUserMove(ClientId client, SessionId id, Game::Position p);
+    bool CloseSession(ClientId client, SessionId id);
+    void CloseClient(ClientId client);
+    Stats GetStats() const;
+
+private:
+    enum SessionFlags : uint8_t
+    {
+        CpuFirst = 1,
+        Pending = 2,
+        Over = 4,
+        Closed = 8,
+    };
+
+    struct Session
+    {
+        uint64_t mUserCells = 0;
+        uint64_t mCpuCells = 0;
+        ClientId mClient = 0;
+        uint8_t mGridSize = 0;  // 0 marks a free slot
+        uint8_t mFlags = 0;
+        uint8_t mLevel = 0;
+    };
+
+    struct Job
+    {
+        SessionId mSession;
+        Clock::time_point mQueued;
+    };
+
+    void Schedule(SessionId id);
+    void Release(SessionId id);
+    void WorkerLoop();
+    void RecordLatency(int ms);
+    static Game MakeGame(const Session& session, Game::Level level);
+    static bool HasLine(uint64_t cells, int gridSize);
+
+private:
+    std::vector<Session> mSessions;
+    std::vector<SessionId> mFreeSessions;
+    size_t mActiveSessions;
+
+    // one queue per client, served round-robin so no client can starve the others
+    std::unordered_map<ClientId, std::deque<Job>> mClientQueues;
+    std::deque<ClientId> mReadyClients;
+    size_t mQueueDepth;
+
+    std::vector<int> mLatencies;
+    size_t mLatencyIndex;
+    long long mMoves;
+
+    int mMoveDeadlineMs;
+    ResultCallback mCallback;
+    bool mShutdown;
+    mutable std::mutex mMutex;
+    std::condition_variable mWork;
+    std::vector<std::thread> mWorkers;
+};
+
+#endif // GAMESERVER_H
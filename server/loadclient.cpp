@@ -0,0 +1,100 @@
+#include "loadclient.h"
+
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+
+LoadClient::LoadClient(int games, int gridSize, QObject* parent)
+    : QObject(parent)
+    , mGameCount(games)
+    , mGridSize(gridSize)
+    , mCreated(0)
+    , mFinished(0)
+{
+    connect(&mSocket, &QTcpSocket::readyRead, this, &LoadClient::ReadLines);
+}
+
+void LoadClient::Start(quint16 port)
+{
+    mSocket.connectToHost(QHostAddress::LocalHost, port);
+    if (!mSocket.waitForConnected())
+    {
+        QTextStream(stderr) << "Could not connect to port " << port << endl;
+        emit Finished();
+        return;
+    }
+
+    for (int i = 0; i < mGameCount; i++)
+        Send(QString("new size %1%2").arg(mGridSize).arg(i % 2 ? " cpufirst" : ""));
+}
+
+void LoadClient::ReadLines()
+{
+    while (mSocket.canReadLine())
+    {
+        QStringList tokens = QString::fromUtf8(mSocket.readLine()).trimmed().split(' ');
+        const QString& reply = tokens[0];
+
+        if (reply == "session" && tokens.size() == 2)
+        {
+            // sessions are answered in request order, cpufirst ones wait for the CPU move
+            bool isCpuFirst = mCreated++ % 2 != 0;
+            mGames.insert(tokens[1].toUInt(), Game(Game::Level::Random, isCpuFirst, mGridSize));
+            if (!isCpuFirst)
+                PlayRandomMove(tokens[1].toUInt());
+        }
+        else if (reply == "move" && tokens.size() == 3)
+        {
+            quint32 id = tokens[1].toUInt();
+            auto game = mGames.find(id);
+            Game::Position p = Game::PositionFromString(tokens[2].toStdString());
+            if (game != mGames.end() && p.mX >= 0 && p.mX < mGridSize && p.mY >= 0 && p.mY < mGridSize &&
+                    game->GetCell(p) == Game::PlayerEntity::None)
+            {
+                game->SetMove(p);
+                PlayRandomMove(id);
+            }
+        }
+        else if (reply == "over" && tokens.size() == 3)
+        {
+            quint32 id = tokens[1].toUInt();
+            mGames.remove(id);
+            Send(QString("close %1").arg(id));
+            if (++mFinished == mGameCount)
+                Send("stats");
+        }
+        else if (reply == "stats")
+        {
+            QTextStream(stdout) << tokens.join(' ') << endl;
+            emit Finished();
+        }
+        else if (reply == "error")
+        {
+            QTextStream(stderr) << tokens.join(' ') << endl;
+        }
+    }
+}
+
+void LoadClient::PlayRandomMove(quint32 id)
+{
+    // a CPU move that ended the game is followed by "over", nothing to play then
+    auto game = mGames.find(id);
+    if (game == mGames.end() || game->GetPlayerAtMove() != Game::PlayerEntity::User)
+        return;
+
+    QVector<Game::Position> empty;
+    for (int i = 0; i < mGridSize; i++)
+        for (int j = 0; j < mGridSize; j++)
+            if (game->GetCell({i, j}) == Game::PlayerEntity::None)
+                empty.append({i, j});
+
+    Game::Position p = empty[QRandomGenerator::global()->bounded(empty.size())];
+    game->SetMove(p);
+    Send(QString("play %1 %2").arg(id).arg(QString::fromStdString(Game::PositionToString(p))));
+}
+
+void LoadClient::Send(const QString& line)
+{
+    mSocket.write(line.toUtf8() + '\n');
+}
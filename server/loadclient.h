@@ -0,0 +1,39 @@
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+
+#include <QObject>
+#include <QHash>
+#include <QTcpSocket>
+#include "game.h"
+
+// Local client that opens many sessions on a running server, plays random user
+// moves until every game is over and prints the server stats.
+class LoadClient : public QObject
+{
+    Q_OBJECT
+public:
+    LoadClient(int games, int gridSize, QObject* parent = nullptr);
+
+    void Start(quint16 port);
+
+signals:
+    void Finished();
+
+private slots:
+    void ReadLines();
+
+private:
+    void PlayRandomMove(quint32 id);
+    void Send(const QString& line);
+
+private:
+    QTcpSocket mSocket;
+    // the position of every open session as the client sees it
+    QHash<quint32, Game> mGames;
+    int mGameCount;
+    int mGridSize;
+    int mCreated;
+    int mFinished;
+};
+
+#endif // LOADCLIENT_H
@@ -0,0 +1,60 @@
+#include "tcpserver.h"
+#include "loadclient.h"
+#include "sessioncheck.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "Local TCP port.", "port", "7777");
+    QCommandLineOption workersOption("workers", "Number of worker threads, defaults to one per core.", "count");
+    QCommandLineOption deadlineOption("deadline", "Time limit per CPU move in ms, including queueing.", "ms",
+                                      QString::number(Game::CpuTimePerMoveMs));
+    QCommandLineOption clientOption("client", "Connect to a running server and play <games> random games.", "games");
+    QCommandLineOption sizeOption("size", "Grid size used by --client.", "size", "3");
+    QCommandLineOption checkOption("check", "Check that clients cannot use each other's sessions and exit.");
+    parser.addOptions({portOption, workersOption, deadlineOption, clientOption, sizeOption, checkOption});
+    parser.process(a);
+
+    if (parser.isSet(checkOption))
+    {
+        std::string failure;
+        if (!CheckSessionOwnership(failure))
+        {
+            QTextStream(stderr) << "session check failed: " << QString::fromStdString(failure) << endl;
+            return 1;
+        }
+
+        QTextStream(stdout) << "session check passed" << endl;
+        return 0;
+    }
+
+    quint16 port = parser.value(portOption).toUShort();
+
+    if (parser.isSet(clientOption))
+    {
+        LoadClient client(parser.value(clientOption).toInt(), parser.value(sizeOption).toInt());
+        QObject::connect(&client, &LoadClient::Finished, &a, &QCoreApplication::quit, Qt::QueuedConnection);
+        client.Start(port);
+        return a.exec();
+    }
+
+    int workers = parser.isSet(workersOption) ? parser.value(workersOption).toInt()
+                                              : static_cast<int>(std::thread::hardware_concurrency());
+
+    TcpServer server(workers, parser.value(deadlineOption).toInt());
+    if (!server.Listen(port))
+    {
+        QTextStream(stderr) << "Could not listen on port " << port << endl;
+        return 1;
+    }
+
+    return a.exec();
+}
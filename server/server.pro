@@ -0,0 +1,27 @@
+QT       -= gui
+QT       += network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-server
+
+include(../core/core.pri)
+
+SOURCES += \
+    gameserver.cpp \
+    loadclient.cpp \
+    main.cpp \
+    sessioncheck.cpp \
+    tcpserver.cpp
+
+HEADERS += \
+    gameserver.h \
+    loadclient.h \
+    sessioncheck.h \
+    tcpserver.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
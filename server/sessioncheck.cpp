@@ -0,0 +1,52 @@
+#include "sessioncheck.h"
+#include "gameserver.h"
+
+#include <condition_variable>
+#include <mutex>
+
+bool CheckSessionOwnership(std::string& failure)
+{
+    enum
+    {
+        Owner = 1,
+        Other = 2,
+        TimeoutMs = 10000,
+    };
+
+    std::mutex mutex;
+    std::condition_variable answered;
+    int moves = 0;
+    GameServer games(1, 100, [&](const GameServer::MoveResult& result)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        moves += result.mClient == Owner && result.mMove.mX != -1;
+        answered.notify_all();
+    });
+
+    auto check = [&failure](bool isPassed, const char* step)
+    {
+        if (!isPassed && failure.empty())
+            failure = step;
+        return isPassed;
+    };
+
+    GameServer::SessionId id = games.CreateSession(Owner, 3, Game::Level::Max, false);
+    check(id != GameServer::InvalidSession, "owner creates a session");
+    check(!games.PlayUserMove(Other, id, {1, 1}), "other client plays in the session");
+    check(!games.CloseSession(Other, id), "other client closes the session");
+    check(games.PlayUserMove(Owner, id, {1, 1}), "owner plays in the session");
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        check(answered.wait_for(lock, std::chrono::milliseconds(TimeoutMs), [&moves]() {return moves > 0;}),
+              "the CPU answers the owner");
+    }
+
+    GameServer::SessionId otherId = games.CreateSession(Other, 3, Game::Level::Max, false);
+    check(!games.PlayUserMove(Owner, otherId, {0, 0}), "owner plays in the session of the other client");
+    check(!games.CloseSession(Owner, otherId), "owner closes the session of the other client");
+    check(games.CloseSession(Other, otherId), "other client closes its session");
+    check(games.CloseSession(Owner, id), "owner closes its session");
+    check(!games.CloseSession(Owner, id), "owner closes its session twice");
+    return failure.empty();
+}
@@ -0,0 +1,11 @@
+#ifndef SESSIONCHECK_H
+#define SESSIONCHECK_H
+
+#include <string>
+
+// Plays through a GameServer with two clients and checks that neither can move
+// in or close a session of the other. Returns false with the first failed
+// step in failure.
+bool CheckSessionOwnership(std::string& failure);
+
+#endif // SESSIONCHECK_H
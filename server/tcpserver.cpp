@@ -0,0 +1,116 @@
+#include "tcpserver.h"
+
+#include <QHostAddress>
+
+TcpServer::TcpServer(int workers, int moveDeadlineMs, QObject* parent)
+    : QObject(parent)
+    , mNextClient(1)
+    , mGames(workers, moveDeadlineMs, [this](const GameServer::MoveResult& result)
+      {
+          // results come from the worker threads, sockets live on this thread
+          QMetaObject::invokeMethod(this, [this, result]() {Deliver(result);}, Qt::QueuedConnection);
+      })
+{
+    connect(&mServer, &QTcpServer::newConnection, this, &TcpServer::NewConnection);
+}
+
+bool TcpServer::Listen(quint16 port)
+{
+    return mServer.listen(QHostAddress::LocalHost, port);
+}
+
+void TcpServer::NewConnection()
+{
+    while (QTcpSocket* socket = mServer.nextPendingConnection())
+    {
+        GameServer::ClientId client = mNextClient++;
+        mClients.insert(client, socket);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, client]() {ReadLines(client);});
+        connect(socket, &QTcpSocket::disconnected, this, [this, client, socket]()
+        {
+            mGames.CloseClient(client);
+            mClients.remove(client);
+            socket->deleteLater();
+        });
+    }
+}
+
+void TcpServer::ReadLines(GameServer::ClientId client)
+{
+    QTcpSocket* socket = mClients.value(client);
+    while (socket && socket->canReadLine())
+        Execute(client, QString::fromUtf8(socket->readLine()).trimmed());
+}
+
+void TcpServer::Execute(GameServer::ClientId client, const QString& line)
+{
+    QStringList tokens = line.split(' ', QString::SkipEmptyParts);
+    if (tokens.isEmpty())
+        return;
+
+    const QString& command = tokens[0];
+    if (command == "new")
+    {
+        int gridSize = 3;
+        int sizeIndex = tokens.indexOf("size");
+        if (sizeIndex != -1 && sizeIndex + 1 < tokens.size())
+            gridSize = tokens[sizeIndex + 1].toInt();
+
+        Game::Level level = Game::Level::Max;
+        int levelIndex = tokens.indexOf("level");
+        if (levelIndex != -1 && levelIndex + 1 < tokens.size())
+            level = static_cast<Game::Level>(qBound(0, tokens[levelIndex + 1].toInt(), static_cast<int>(Game::Level::Max)));
+        else if (tokens.contains("easy"))
+            level = Game::Level::Random;
+
+        GameServer::SessionId id = mGames.CreateSession(client, gridSize, level, tokens.contains("cpufirst"));
+        if (id == GameServer::InvalidSession)
+            Send(client, "error unsupported size");
+        else
+            Send(client, QString("session %1").arg(id));
+    }
+    else if (command == "play" && tokens.size() == 3)
+    {
+        Game::Position p = Game::PositionFromString(tokens[2].toStdString());
+        if (!mGames.PlayUserMove(client, tokens[1].toUInt(), p))
+            Send(client, "error illegal move " + tokens[2]);
+    }
+    else if (command == "close" && tokens.size() == 2)
+    {
+        if (!mGames.CloseSession(client, tokens[1].toUInt()))
+            Send(client, "error unknown session " + tokens[1]);
+    }
+    else if (command == "stats")
+    {
+        GameServer::Stats stats = mGames.GetStats();
+        Send(client, QString("stats sessions %1 queue %2 moves %3 p50 %4 p99 %5")
+             .arg(stats.mSessions).arg(stats.mQueueDepth).arg(stats.mMoves).arg(stats.mP50Ms).arg(stats.mP99Ms));
+    }
+    else
+    {
+        Send(client, "error unknown command " + command);
+    }
+}
+
+void TcpServer::Deliver(const GameServer::MoveResult& result)
+{
+    if (result.mMove.mX != -1)
+        Send(result.mClient, QString("move %1 %2").arg(result.mSession).arg(QString::fromStdString(Game::PositionToString(result.mMove))));
+
+    if (result.mIsOver)
+    {
+        const char* winner = "draw";
+        if (result.mWinner == Game::PlayerEntity::User)
+            winner = "user";
+        else if (result.mWinner == Game::PlayerEntity::Cpu)
+            winner = "cpu";
+        Send(result.mClient, QString("over %1 %2").arg(result.mSession).arg(winner));
+    }
+}
+
+void TcpServer::Send(GameServer::ClientId client, const QString& line)
+{
+    if (QTcpSocket* socket = mClients.value(client))
+        socket->write(line.toUtf8() + '\n');
+}
@@ -0,0 +1,41 @@
+#ifndef TCPSERVER_H
+#define TCPSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "gameserver.h"
+
+// Line protocol, one command per line:
+//  new size <n> [level <0-4>|easy] [cpufirst]  -> session <id>
+//  play <id> <cell>                -> move <id> <cell> and/or over <id> <user|cpu|draw>
+//  close <id>
+//  stats                           -> stats sessions <n> queue <q> moves <m> p50 <ms> p99 <ms>
+// Failures are answered with "error <reason>". A client can only play in and
+// close its own sessions, the sessions of other clients are unknown to it.
+class TcpServer : public QObject
+{
+    Q_OBJECT
+public:
+    TcpServer(int workers, int moveDeadlineMs, QObject* parent = nullptr);
+
+    bool Listen(quint16 port);
+
+private slots:
+    void NewConnection();
+
+private:
+    void ReadLines(GameServer::ClientId client);
+    void Execute(GameServer::ClientId client, const QString& line);
+    void Deliver(const GameServer::MoveResult& result);
+    void Send(GameServer::ClientId client, const QString& line);
+
+private:
+    QTcpServer mServer;
+    QHash<GameServer::ClientId, QTcpSocket*> mClients;
+    GameServer::ClientId mNextClient;
+    GameServer mGames;
+};
+
+#endif // TCPSERVER_H
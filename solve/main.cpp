@@ -0,0 +1,290 @@
+// Scores a file of positions with the engine search on all cores.
+//
+//  tictactoe-solve [--config <config>] [--threads <n>] [--seed <s>]
+//                  [--output <file>] [<positions> | -]
+//
+// Each input line ("-" or no file reads stdin) is a position code
+// (core/positioncode.h) or "<size> <moves>" with the moves comma separated from
+// the empty board and "-" for none, as tictactoe-stats reads them. The side to
+// move is searched with the settings of the config (core/engineconfig.h),
+// whose nodes and movetime limit every position. The output has one line per
+// input line, in the same order:
+//
+//  <code> bestmove <m> score <s> depth <d> nodes <n> time <ms>
+//
+// with the score from the point of view of the side to move as in the engine
+// protocol, "<code> bestmove none" for a finished game and "<line> error" for a
+// line that is not a position. Empty lines and lines starting with '#' are
+// copied as they are. Results are written as soon as all lines before them
+// are done, workers run at most a few positions per thread ahead.
+
+#include "engineconfig.h"
+#include "game.h"
+#include "patterneval.h"
+#include "positionstats.h"
+#include "searchcache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+enum
+{
+    PendingPerThread = 16,
+};
+
+struct Options
+{
+    EngineConfig mConfig;
+    std::string mInput;
+    std::string mOutput;
+    int mThreads = 0;
+    uint32_t mSeed = 1;
+};
+
+static bool ParsePosition(const std::string& line, PositionCode& code)
+{
+    if (line.find(':') != std::string::npos)
+        return code.ParseText(line);
+
+    std::istringstream in(line);
+    int gridSize = 0;
+    std::string moves;
+    if (!(in >> gridSize >> moves) || !Geometry::IsSupported(gridSize))
+        return false;
+
+    Game game(Game::Level::Random, true, gridSize);
+    if (moves == "-")
+        moves.clear();
+    std::istringstream list(moves);
+    std::string move;
+    while (std::getline(list, move, ','))
+    {
+        Game::Position p = Game::PositionFromString(move);
+        if (p.mX < 0 || p.mX >= gridSize || p.mY < 0 || p.mY >= gridSize ||
+                game.GetPlayerAtMove() == Game::PlayerEntity::None || game.GetCell(p) != Game::PlayerEntity::None)
+            return false;
+        game.SetMove(p);
+    }
+
+    code = game.GetPositionCode();
+    return true;
+}
+
+class Solver
+{
+public:
+    Solver(const Options& options, std::istream& input, std::ostream& output)
+        : mOptions(options)
+        , mInput(input)
+        , mOutput(output)
+        , mNextRead(0)
+        , mNextWrite(0)
+        , mWindow(0)
+        , mIsInputDone(false)
+    {
+    }
+
+    bool Run()
+    {
+        if (!mOptions.mConfig.mStatsPath.empty())
+        {
+            mStats.reset(new PositionStats());
+            if (!mStats->Load(mOptions.mConfig.mStatsPath))
+            {
+                std::cerr << "cannot load " << mOptions.mConfig.mStatsPath << std::endl;
+                return false;
+            }
+        }
+
+        if (!mOptions.mConfig.mEvalPath.empty())
+        {
+            mEval.reset(new PatternEval());
+            if (!mEval->Load(mOptions.mConfig.mEvalPath))
+            {
+                std::cerr << "cannot load " << mOptions.mConfig.mEvalPath << std::endl;
+                return false;
+            }
+        }
+
+        int threads = mOptions.mThreads > 0 ? mOptions.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        mWindow = threads * PendingPerThread;
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back(&Solver::WorkerLoop, this);
+        for (auto& worker : workers)
+            worker.join();
+
+        mOutput.flush();
+        return static_cast<bool>(mOutput);
+    }
+
+private:
+    void WorkerLoop()
+    {
+        long long index;
+        std::string line;
+        while (Take(index, line))
+            Put(index, Solve(index, line));
+    }
+
+    // the next input line, once the output has caught up far enough
+    bool Take(long long& index, std::string& line)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSpace.wait(lock, [this]() {return mNextRead - mNextWrite < mWindow;});
+        if (mIsInputDone || !std::getline(mInput, line))
+        {
+            mIsInputDone = true;
+            return false;
+        }
+
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        index = mNextRead++;
+        return true;
+    }
+
+    // writes the result and every result after it that is already done
+    void Put(long long index, std::string&& result)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending[index] = std::move(result);
+        for (auto found = mPending.find(mNextWrite); found != mPending.end(); found = mPending.find(mNextWrite))
+        {
+            mOutput << found->second << '\n';
+            mPending.erase(found);
+            mNextWrite++;
+        }
+        mSpace.notify_all();
+    }
+
+    // one cache per grid size in the input, shared by all workers
+    SearchCache* GetCache(int gridSize)
+    {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        std::unique_ptr<SearchCache>& cache = mCaches[gridSize];
+        if (!cache)
+            cache.reset(new SearchCache(gridSize, Game::EngineVersion, mOptions.mConfig.mCacheMegabytes));
+        return cache.get();
+    }
+
+    std::string Solve(long long index, const std::string& line)
+    {
+        if (line.empty() || line[0] == '#')
+            return line;
+
+        PositionCode code;
+        if (!ParsePosition(line, code))
+            return line + " error";
+
+        // the engine plays the side to move as the CPU, the output keeps the code as read
+        Game game = mOptions.mConfig.MakeGame(code.mIsCpuToMove ? code : code.GetSwapped());
+        if (game.GetPlayerAtMove() != Game::PlayerEntity::Cpu)
+            return code.ToText() + " bestmove none";
+
+        game.SetSeed(mOptions.mSeed + static_cast<uint32_t>(index));
+        game.SetSearchCache(GetCache(code.mGridSize));
+        game.SetPositionStats(mStats.get());
+        game.SetPatternEval(mEval.get());
+
+        auto start = std::chrono::steady_clock::now();
+        Game::Position p = game.FindCpuMove();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        const Game::SearchInfo& info = game.GetSearchInfo();
+        std::ostringstream result;
+        result << code.ToText() << " bestmove " << Game::PositionToString(p) << " score " << info.mScore
+               << " depth " << info.mDepth << " nodes " << info.mNodes << " time " << ms;
+        return result.str();
+    }
+
+private:
+    const Options& mOptions;
+    std::istream& mInput;
+    std::ostream& mOutput;
+    std::mutex mCacheMutex;
+    std::map<int, std::unique_ptr<SearchCache>> mCaches;
+    std::unique_ptr<PositionStats> mStats;
+    std::unique_ptr<PatternEval> mEval;
+
+    std::mutex mMutex;
+    std::condition_variable mSpace;
+    std::map<long long, std::string> mPending;
+    long long mNextRead;
+    long long mNextWrite;
+    long long mWindow;
+    bool mIsInputDone;
+};
+
+int main(int argc, char *argv[])
+{
+    std::ios::sync_with_stdio(false);
+
+    Options options;
+    bool isValid = true;
+    for (int i = 1; i < argc && isValid; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc)
+            isValid = options.mConfig.Parse(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+            options.mThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            options.mSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--output" && i + 1 < argc)
+            options.mOutput = argv[++i];
+        else if (options.mInput.empty() && (arg == "-" || arg.compare(0, 2, "--") != 0))
+            options.mInput = arg;
+        else
+            isValid = false;
+    }
+
+    if (!isValid)
+    {
+        std::cerr << "usage: tictactoe-solve [--config <config>] [--threads <n>] [--seed <s>]\n"
+                     "                       [--output <file>] [<positions> | -]\n"
+                     "config: " << EngineConfig::GetUsage() << std::endl;
+        return 2;
+    }
+
+    std::ifstream inputFile;
+    if (!options.mInput.empty() && options.mInput != "-")
+    {
+        inputFile.open(options.mInput);
+        if (!inputFile)
+        {
+            std::cerr << "cannot read " << options.mInput << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream outputFile;
+    if (!options.mOutput.empty())
+    {
+        outputFile.open(options.mOutput, std::ios::trunc);
+        if (!outputFile)
+        {
+            std::cerr << "cannot write " << options.mOutput << std::endl;
+            return 1;
+        }
+    }
+
+    Solver solver(options, inputFile.is_open() ? static_cast<std::istream&>(inputFile) : std::cin,
+                  outputFile.is_open() ? static_cast<std::ostream&>(outputFile) : std::cout);
+    if (!solver.Run())
+    {
+        std::cerr << "cannot write " << (options.mOutput.empty() ? "the output" : options.mOutput) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Builds the position statistics database (core/positionstats.h) from played
+// games, adding to what the file already holds.
+//
+//  tictactoe-stats <database> [games ...]
+//  tictactoe-stats <database> --lookup <position code>
+//
+// Each games file ("-" for stdin) holds one game per line, either as written
+// by tictactoe-tournament ("game ... size <n> opening <moves> ... moves
+// <moves>") or as "<size> <moves>", with the moves comma separated from the
+// empty board. Every position of a game counts a visit, finished games also
+// count a win, draw or loss for the side to move. Without games the number of
+// positions in the database is printed.
+
+#include "game.h"
+#include "positionstats.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static void AppendMoves(const std::string& text, std::vector<Game::Position>& moves)
+{
+    if (text == "-")
+        return;
+
+    std::istringstream in(text);
+    std::string move;
+    while (std::getline(in, move, ','))
+        moves.push_back(Game::PositionFromString(move));
+}
+
+static bool ParseGame(const std::string& line, int& gridSize, std::vector<Game::Position>& moves)
+{
+    std::istringstream in(line);
+    std::string token;
+    if (!(in >> token))
+        return false;
+
+    moves.clear();
+    if (token != "game")
+    {
+        std::string text;
+        gridSize = std::atoi(token.c_str());
+        if (!(in >> text))
+            return false;
+        AppendMoves(text, moves);
+        return true;
+    }
+
+    // the opening comes before the rest of the moves on a tournament line
+    gridSize = 0;
+    std::string value;
+    in >> value;
+    while (in >> token >> value)
+    {
+        if (token == "size")
+            gridSize = std::atoi(value.c_str());
+        else if (token == "opening" || token == "moves")
+            AppendMoves(value, moves);
+    }
+    return true;
+}
+
+// one record per position the game went through, the first mover plays as the CPU
+static bool AddGame(int gridSize, const std::vector<Game::Position>& moves, std::vector<PositionStats::Record>& records)
+{
+    if (!Geometry::IsSupported(gridSize))
+        return false;
+
+    Game game(Game::Level::Random, true, gridSize);
+    for (auto& p : moves)
+    {
+        if (p.mX < 0 || p.mX >= gridSize || p.mY < 0 || p.mY >= gridSize ||
+                game.GetPlayerAtMove() == Game::PlayerEntity::None || game.GetCell(p) != Game::PlayerEntity::None)
+            return false;
+        game.SetMove(p);
+    }
+
+    bool isOver = game.GetPlayerAtMove() == Game::PlayerEntity::None;
+    Game::PlayerEntity winner = game.GetWinner();
+    for (;;)
+    {
+        PositionCode code = game.GetPositionCode();
+        Game::PlayerEntity mover = code.mIsCpuToMove ? Game::PlayerEntity::Cpu : Game::PlayerEntity::User;
+
+        PositionStats::Record record = {PositionStats::GetKey(code), 1, 0, 0, 0};
+        if (isOver)
+        {
+            if (winner == Game::PlayerEntity::None)
+                record.mDraws = 1;
+            else if (winner == mover)
+                record.mWins = 1;
+            else
+                record.mLosses = 1;
+        }
+        records.push_back(record);
+
+        if (!game.CanUndo())
+            return true;
+        game.UndoMove();
+    }
+}
+
+static int Lookup(const std::string& path, const std::string& text)
+{
+    PositionStats stats;
+    PositionCode code;
+    if (!stats.Load(path) || !code.ParseText(text))
+    {
+        std::cerr << "cannot load " << path << " or parse " << text << std::endl;
+        return 1;
+    }
+
+    PositionStats::Record record;
+    if (!stats.Find(PositionStats::GetKey(code), record))
+    {
+        std::cout << "not found" << std::endl;
+        return 0;
+    }
+
+    std::cout << "visits " << record.mVisits << " wins " << record.mWins << " draws " << record.mDraws
+              << " losses " << record.mLosses << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: tictactoe-stats <database> [games ...]\n"
+                     "       tictactoe-stats <database> --lookup <position code>" << std::endl;
+        return 2;
+    }
+
+    std::string path = argv[1];
+    if (argc == 4 && std::string(argv[2]) == "--lookup")
+        return Lookup(path, argv[3]);
+
+    std::vector<PositionStats::Record> records;
+    int games = 0, skipped = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string name = argv[i];
+        std::ifstream file;
+        if (name != "-")
+        {
+            file.open(name);
+            if (!file)
+            {
+                std::cerr << "cannot read " << name << std::endl;
+                return 1;
+            }
+        }
+
+        std::istream& in = name == "-" ? std::cin : file;
+        std::string line;
+        int gridSize;
+        std::vector<Game::Position> moves;
+        while (std::getline(in, line))
+        {
+            if (!ParseGame(line, gridSize, moves))
+                continue;
+
+            if (AddGame(gridSize, moves, records))
+                games++;
+            else
+                skipped++;
+        }
+    }
+
+    if (argc > 2 && !PositionStats::Merge(path, std::move(records)))
+    {
+        std::cerr << "cannot update " << path << ", it is not a valid database or cannot be written" << std::endl;
+        return 1;
+    }
+
+    PositionStats stats;
+    stats.Load(path);
+    std::cout << games << " games added, " << skipped << " skipped, " << stats.GetSize() << " positions" << std::endl;
+    return 0;
+}
@@ -0,0 +1,11 @@
+CONFIG -= qt
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tictactoe-stats
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
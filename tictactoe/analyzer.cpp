@@ -0,0 +1,56 @@
+#include "analyzer.h"
+#include "trace.h"
+
+#include <QtConcurrent>
+
+Analyzer::Analyzer(QObject* parent)
+    : QObject(parent)
+    , mStop(false)
+    , mGeneration(0)
+{
+    qRegisterMetaType<std::vector<Game::CellAnalysis>>();
+
+    // reports are emitted on the worker and queued back to this thread
+    connect(this, &Analyzer::Report, this, &Analyzer::Deliver, Qt::QueuedConnection);
+}
+
+Analyzer::~Analyzer()
+{
+    Stop();
+    Wait();
+}
+
+void Analyzer::Start(Game game)
+{
+    TRACE_SCOPE("Analyzer::Start");
+    Stop();
+    Wait();
+
+    mStop = false;
+    int generation = mGeneration;
+
+    game.SetStopFlag(&mStop);
+    mWatcher.setFuture(QtConcurrent::run([this, game, generation]() mutable
+    {
+        TRACE_SCOPE("Analyzer::Analyze");
+        game.Analyze([this, generation](const std::vector<Game::CellAnalysis>& cells, int depth)
+        {
+            emit Report(generation, cells, depth);
+        });
+    }));
+}
+
+void Analyzer::Stop()
+{
+    mGeneration++;
+    mStop = true;
+}
+
+void Analyzer::Deliver(int generation, const std::vector<Game::CellAnalysis>& cells, int depth)
+{
+    // anything still queued from a stopped run belongs to an old position
+    if (generation != mGeneration)
+        return;
+
+    emit Updated(cells, depth);
+}
@@ -0,0 +1,39 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <atomic>
+#include <vector>
+#include "game.h"
+
+Q_DECLARE_METATYPE(std::vector<Game::CellAnalysis>)
+
+// Scores every empty cell of a Game copy on the thread pool until stopped and
+// reports each deeper round. Stopping drops the pending reports at once, the
+// search itself winds down in the background.
+class Analyzer : public QObject
+{
+    Q_OBJECT
+public:
+    Analyzer(QObject* parent = nullptr);
+    ~Analyzer();
+
+    void Start(Game game);
+    void Stop();
+    void Wait() {mWatcher.waitForFinished();}
+
+signals:
+    void Updated(const std::vector<Game::CellAnalysis>& cells, int depth);
+    void Report(int generation, const std::vector<Game::CellAnalysis>& cells, int depth);
+
+private slots:
+    void Deliver(int generation, const std::vector<Game::CellAnalysis>& cells, int depth);
+
+private:
+    QFutureWatcher<void> mWatcher;
+    std::atomic_bool mStop;
+    std::atomic_int mGeneration;
+};
+
+#endif // ANALYZER_H
@@ -0,0 +1,67 @@
+#include "asyncengine.h"
+#include "trace.h"
+
+#include <QtConcurrent>
+
+AsyncEngine::AsyncEngine(QObject* parent)
+    : QObject(parent)
+    , mStop(false)
+    , mCancelled(false)
+{
+    connect(&mWatcher, &QFutureWatcher<Game::Position>::finished, this, &AsyncEngine::Finished);
+}
+
+AsyncEngine::~AsyncEngine()
+{
+    Cancel();
+    Wait();
+}
+
+void AsyncEngine::Start(Game game)
+{
+    TRACE_SCOPE("AsyncEngine::Start");
+    // a cancelled search is already stopping, let it go before reusing the flag
+    Wait();
+
+    mStop = false;
+    mCancelled = false;
+
+    QElapsedTimer throttle;
+    throttle.start();
+    game.SetStopFlag(&mStop);
+    game.SetInfoCallback([this, throttle](const Game::SearchInfo& info) mutable
+    {
+        if (throttle.elapsed() < ProgressIntervalMs)
+            return;
+
+        throttle.restart();
+        emit Progress(info.mBestMove.mX, info.mBestMove.mY, info.mScore, info.mDepth, info.mNodes);
+    });
+
+    mWatcher.setFuture(QtConcurrent::run([game]() mutable
+    {
+        TRACE_SCOPE("AsyncEngine::Search");
+        return game.FindCpuMove();
+    }));
+}
+
+void AsyncEngine::MoveNow()
+{
+    mStop = true;
+}
+
+void AsyncEngine::Cancel()
+{
+    mCancelled = true;
+    mStop = true;
+}
+
+void AsyncEngine::Finished()
+{
+    TRACE_SCOPE("AsyncEngine::Finished");
+    if (mCancelled)
+        return;
+
+    Game::Position p = mWatcher.result();
+    emit MoveReady(p.mX, p.mY);
+}
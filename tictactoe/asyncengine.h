@@ -0,0 +1,42 @@
+#ifndef ASYNCENGINE_H
+#define ASYNCENGINE_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <atomic>
+#include "game.h"
+
+// Runs the CPU search of a Game copy on the thread pool. While searching it
+// reports the best move so far at most every ProgressIntervalMs.
+class AsyncEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum
+    {
+        ProgressIntervalMs = 50,
+    };
+
+    AsyncEngine(QObject* parent = nullptr);
+    ~AsyncEngine();
+
+    void Start(Game game);
+    void MoveNow();
+    void Cancel();
+    void Wait() {mWatcher.waitForFinished();}
+    bool IsRunning() const {return mWatcher.isRunning();}
+
+signals:
+    void Progress(int posX, int posY, int score, int depth, qint64 nodes);
+    void MoveReady(int posX, int posY);
+
+private slots:
+    void Finished();
+
+private:
+    QFutureWatcher<Game::Position> mWatcher;
+    std::atomic_bool mStop;
+    bool mCancelled;
+};
+
+#endif // ASYNCENGINE_H
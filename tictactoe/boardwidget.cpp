@@ -0,0 +1,162 @@
+#include "boardwidget.h"
+#include "trace.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+static const int sCellSpacing = 1;
+
+BoardWidget::BoardWidget(QWidget* parent)
+    : QWidget(parent)
+    , mGridSize(0)
+    , mCellSize(0)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void BoardWidget::SetGridSize(int gridSize)
+{
+    mGridSize = gridSize;
+    mMarks.fill(Game::UiSign::None, gridSize * gridSize);
+    mCandidate = Game::Position();
+    mHeat.fill(QColor(), gridSize * gridSize);
+    UpdateGeometry();
+    update();
+}
+
+void BoardWidget::SetMark(Game::Position p, Game::UiSign sign)
+{
+    Game::UiSign& mark = mMarks[p.mX * mGridSize + p.mY];
+    if (mark == sign)
+        return;
+
+    mark = sign;
+    update(GetCellRect(p.mX, p.mY));
+}
+
+void BoardWidget::SetCandidate(Game::Position p)
+{
+    if (p.mX == mCandidate.mX && p.mY == mCandidate.mY)
+        return;
+
+    if (mCandidate.mX != -1)
+        update(GetCellRect(mCandidate.mX, mCandidate.mY));
+
+    mCandidate = p;
+    if (mCandidate.mX != -1)
+        update(GetCellRect(mCandidate.mX, mCandidate.mY));
+}
+
+void BoardWidget::SetHeat(const std::vector<Game::CellAnalysis>& cells)
+{
+    for (const auto& cell : cells)
+    {
+        // wins green, losses red and draws grey, estimates only faintly
+        QColor color;
+        if (cell.mScore > Game::ScoreDefines::Draw)
+            color = QColor(60, 180, 60);
+        else if (cell.mScore == Game::ScoreDefines::Draw)
+            color = QColor(128, 128, 160);
+        else if (cell.mScore != Game::ScoreDefines::TooComplex)
+            color = QColor(200, 60, 60);
+
+        if (color.isValid())
+            color.setAlpha(cell.mIsExact ? 160 : 60);
+
+        QColor& heat = mHeat[cell.mCell.mX * mGridSize + cell.mCell.mY];
+        if (heat != color)
+        {
+            heat = color;
+            update(GetCellRect(cell.mCell.mX, cell.mCell.mY));
+        }
+    }
+}
+
+void BoardWidget::ClearHeat()
+{
+    for (int i = 0; i < mHeat.size(); i++)
+    {
+        if (!mHeat[i].isValid())
+            continue;
+
+        mHeat[i] = QColor();
+        update(GetCellRect(i / mGridSize, i % mGridSize));
+    }
+}
+
+void BoardWidget::paintEvent(QPaintEvent* event)
+{
+    TRACE_SCOPE("BoardWidget::paintEvent");
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().window());
+
+    if (mGridSize == 0)
+        return;
+
+    QFont f = font();
+    f.setPixelSize(qMax(1, mCellSize / 2));
+    painter.setFont(f);
+
+    // only the cells touching the dirty region are drawn
+    const QRect& dirty = event->rect();
+    int firstRow = qMax(0, (dirty.top() - mOrigin.y()) / mCellSize);
+    int lastRow = qMin(mGridSize - 1, (dirty.bottom() - mOrigin.y()) / mCellSize);
+    int firstColumn = qMax(0, (dirty.left() - mOrigin.x()) / mCellSize);
+    int lastColumn = qMin(mGridSize - 1, (dirty.right() - mOrigin.x()) / mCellSize);
+
+    for (int i = firstRow; i <= lastRow; i++)
+    {
+        for (int j = firstColumn; j <= lastColumn; j++)
+        {
+            QRect cell = GetCellRect(i, j);
+            bool isCandidate = i == mCandidate.mX && j == mCandidate.mY;
+            painter.fillRect(cell, isCandidate ? palette().highlight() : palette().button());
+            if (!isCandidate && mHeat[i * mGridSize + j].isValid())
+                painter.fillRect(cell, mHeat[i * mGridSize + j]);
+
+            switch (mMarks[i * mGridSize + j])
+            {
+            case Game::UiSign::None: break;
+            case Game::UiSign::X: painter.drawText(cell, Qt::AlignCenter, "X"); break;
+            case Game::UiSign::O: painter.drawText(cell, Qt::AlignCenter, "O"); break;
+            }
+        }
+    }
+}
+
+void BoardWidget::mousePressEvent(QMouseEvent* event)
+{
+    if (mGridSize == 0 || event->button() != Qt::LeftButton)
+        return;
+
+    QPoint p = event->pos() - mOrigin;
+    if (p.x() < 0 || p.y() < 0)
+        return;
+
+    int x = p.y() / mCellSize;
+    int y = p.x() / mCellSize;
+    if (x < mGridSize && y < mGridSize && GetCellRect(x, y).contains(event->pos()))
+        emit CellClicked(x, y);
+}
+
+void BoardWidget::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    UpdateGeometry();
+}
+
+QRect BoardWidget::GetCellRect(int x, int y) const
+{
+    return QRect(mOrigin.x() + y * mCellSize, mOrigin.y() + x * mCellSize,
+                 mCellSize - sCellSpacing, mCellSize - sCellSpacing);
+}
+
+void BoardWidget::UpdateGeometry()
+{
+    if (mGridSize == 0)
+        return;
+
+    mCellSize = qMax(1, qMin(width(), height()) / mGridSize);
+    mOrigin = QPoint((width() - mCellSize * mGridSize) / 2, (height() - mCellSize * mGridSize) / 2);
+}
@@ -0,0 +1,44 @@
+#ifndef BOARDWIDGET_H
+#define BOARDWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include "game.h"
+
+// Paints the whole grid in one widget, only the cells that changed are repainted.
+class BoardWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    BoardWidget(QWidget* parent = nullptr);
+
+    void SetGridSize(int gridSize);
+    void SetMark(Game::Position p, Game::UiSign sign);
+    void SetCandidate(Game::Position p);
+    void SetHeat(const std::vector<Game::CellAnalysis>& cells);
+    void ClearHeat();
+
+signals:
+    void CellClicked(int posX, int posY);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    QRect GetCellRect(int x, int y) const;
+    void UpdateGeometry();
+
+private:
+    int mGridSize;
+    QVector<Game::UiSign> mMarks;
+    Game::Position mCandidate;
+    QVector<QColor> mHeat;
+
+    // cells are square and the grid is centered in the widget
+    int mCellSize;
+    QPoint mOrigin;
+};
+
+#endif // BOARDWIDGET_H
@@ -0,0 +1,117 @@
+#include "engineprocess.h"
+
+EngineProcess::EngineProcess(QObject* parent)
+    : QObject(parent)
+    , mSearching(false)
+    , mIsFailed(false)
+    , mStaleResults(0)
+{
+    connect(&mProcess, &QProcess::readyReadStandardOutput, this, &EngineProcess::ReadOutput);
+    connect(&mProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &EngineProcess::ProcessStopped);
+    connect(&mProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
+    {
+        // a timeout of a waitFor call leaves the process running, Start reports a failed start
+        if (error != QProcess::Timedout && error != QProcess::FailedToStart)
+            ProcessStopped();
+    });
+}
+
+EngineProcess::~EngineProcess()
+{
+    // quitting is no failure, and whoever listens may be gone already
+    disconnect(&mProcess, nullptr, this, nullptr);
+    if (IsStarted())
+    {
+        Send("quit");
+        if (!mProcess.waitForFinished(1000))
+            mProcess.kill();
+    }
+}
+
+bool EngineProcess::Start(const QString& program)
+{
+    mIsFailed = false;
+    mProcess.start(program, QStringList());
+    if (!mProcess.waitForStarted())
+        return false;
+
+    Send("tictactoe");
+    return true;
+}
+
+void EngineProcess::Search(int gridSize, Game::Level level, const QStringList& moves, int moveTimeMs)
+{
+    mSearching = true;
+
+    Send(QString("newgame size %1 level %2").arg(gridSize).arg(static_cast<int>(level)));
+    Send(moves.isEmpty() ? QString("position") : "position moves " + moves.join(' '));
+    Send(QString("go movetime %1").arg(moveTimeMs));
+}
+
+void EngineProcess::MoveNow()
+{
+    if (mSearching)
+        Send("stop");
+}
+
+void EngineProcess::Cancel()
+{
+    if (!mSearching)
+        return;
+
+    // the engine still answers the cancelled search with a bestmove, skip it
+    mSearching = false;
+    mStaleResults++;
+    Send("stop");
+}
+
+void EngineProcess::ReadOutput()
+{
+    while (mProcess.canReadLine())
+    {
+        QString line = QString::fromUtf8(mProcess.readLine()).trimmed();
+        if (line.startsWith("info ") && mStaleResults == 0)
+        {
+            // info depth <d> nodes <n> score <s> pv <m>
+            QStringList tokens = line.split(' ');
+            int depth = tokens.value(tokens.indexOf("depth") + 1).toInt();
+            qint64 nodes = tokens.value(tokens.indexOf("nodes") + 1).toLongLong();
+            int score = tokens.value(tokens.indexOf("score") + 1).toInt();
+            Game::Position p = Game::PositionFromString(tokens.value(tokens.indexOf("pv") + 1).toStdString());
+            if (p.mX != -1)
+                emit Progress(p.mX, p.mY, score, depth, nodes);
+            continue;
+        }
+
+        if (!line.startsWith("bestmove "))
+            continue;
+
+        if (mStaleResults > 0)
+        {
+            mStaleResults--;
+            continue;
+        }
+
+        mSearching = false;
+        Game::Position p = Game::PositionFromString(line.mid(9).toStdString());
+        if (p.mX != -1)
+            emit MoveReady(p.mX, p.mY);
+    }
+}
+
+void EngineProcess::ProcessStopped()
+{
+    // a crash reports an error and then finished, tell only once
+    if (mIsFailed)
+        return;
+
+    mIsFailed = true;
+    mSearching = false;
+    mStaleResults = 0;
+    emit Failed(mProcess.error() == QProcess::UnknownError ? tr("the engine exited") : mProcess.errorString());
+}
+
+void EngineProcess::Send(const QString& line)
+{
+    mProcess.write(line.toUtf8() + '\n');
+}
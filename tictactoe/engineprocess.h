@@ -0,0 +1,46 @@
+#ifndef ENGINEPROCESS_H
+#define ENGINEPROCESS_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include "game.h"
+
+// Drives an out-of-process engine (see engine/main.cpp) over its stdin/stdout.
+class EngineProcess : public QObject
+{
+    Q_OBJECT
+public:
+    EngineProcess(QObject* parent = nullptr);
+    ~EngineProcess();
+
+    bool Start(const QString& program);
+    // false again once the process has exited or crashed
+    bool IsStarted() const {return !mIsFailed && mProcess.state() != QProcess::NotRunning;}
+    bool IsSearching() const {return mSearching;}
+
+    void Search(int gridSize, Game::Level level, const QStringList& moves, int moveTimeMs);
+    void MoveNow();
+    void Cancel();
+
+signals:
+    void Progress(int posX, int posY, int score, int depth, qint64 nodes);
+    void MoveReady(int posX, int posY);
+    // the process ended on its own, a running search is dropped
+    void Failed(const QString& reason);
+
+private slots:
+    void ReadOutput();
+    void ProcessStopped();
+
+private:
+    void Send(const QString& line);
+
+private:
+    QProcess mProcess;
+    bool mSearching;
+    bool mIsFailed;
+    int mStaleResults;
+};
+
+#endif // ENGINEPROCESS_H
@@ -1,11 +1,36 @@
 #include "mainwindow.h"
+#include "trace.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption engineOption("engine", "Use an external engine executable instead of the built-in one.", "path");
+    parser.addOption(engineOption);
+    QCommandLineOption cacheOption("cache", "Load the search cache from <dir> on start and save it on exit.", "dir");
+    parser.addOption(cacheOption);
+    QCommandLineOption statsOption("stats", "Order and break ties between moves with a position statistics database.", "file");
+    parser.addOption(statsOption);
+    QCommandLineOption traceOption("trace", "Write a Chrome trace of the session to <file> on exit (needs CONFIG+=trace).", "file");
+    parser.addOption(traceOption);
+    parser.process(a);
+
     MainWindow w;
+    if (parser.isSet(cacheOption))
+        w.SetCacheDirectory(parser.value(cacheOption));
+    if (parser.isSet(statsOption) && !w.LoadPositionStats(parser.value(statsOption)))
+        qWarning("Could not load position statistics %s", qPrintable(parser.value(statsOption)));
+    if (parser.isSet(engineOption) && !w.UseExternalEngine(parser.value(engineOption)))
+        qWarning("Could not start engine %s, using the built-in one", qPrintable(parser.value(engineOption)));
     w.show();
-    return a.exec();
+    int result = a.exec();
+
+    if (parser.isSet(traceOption) && !Trace::Dump(parser.value(traceOption).toStdString()))
+        qWarning("Could not write trace %s", qPrintable(parser.value(traceOption)));
+    return result;
 }
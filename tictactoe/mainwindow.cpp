@@ -1,27 +1,81 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "boardwidget.h"
+#include "trace.h"
 
+#include <QDir>
 #include <QMessageBox>
 #include <QTimer>
 
-static const char* sXPos = "xpos";
-static const char* sYPos = "ypos";
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , mWorker(mGame)
 {
     ui->setupUi(this);    
-    connect(&mWorker, &GameThread::CpuResultReady, this, &MainWindow::CpuResultReady);
+
+    mBoard = new BoardWidget(this);
+    ui->glGame->addWidget(mBoard, 0, 0);
+    connect(mBoard, &BoardWidget::CellClicked, this, &MainWindow::PlayerClicked);
+
+    connect(&mCpu, &AsyncEngine::Progress, this, &MainWindow::CpuProgress);
+    connect(&mCpu, &AsyncEngine::MoveReady, this, &MainWindow::CpuMoveReady);
+    connect(&mEngine, &EngineProcess::Progress, this, &MainWindow::CpuProgress);
+    connect(&mEngine, &EngineProcess::MoveReady, this, &MainWindow::CpuMoveReady);
+    connect(&mEngine, &EngineProcess::Failed, this, &MainWindow::EngineFailed);
+    connect(&mAnalyzer, &Analyzer::Updated, this, &MainWindow::AnalysisUpdated);
     GoToOptions();
 }
 
 MainWindow::~MainWindow()
 {
+    // the search has to finish before its cache is saved
+    mCpu.Cancel();
+    mCpu.Wait();
+    mAnalyzer.Stop();
+    mAnalyzer.Wait();
+
+    if (!mCacheDirectory.isEmpty())
+        for (auto& cache : mCaches)
+            cache.second->Save(GetCachePath(cache.first).toStdString());
+
     delete ui;
 }
 
+bool MainWindow::UseExternalEngine(const QString& program)
+{
+    return mEngine.Start(program);
+}
+
+void MainWindow::SetCacheDirectory(const QString& directory)
+{
+    mCacheDirectory = directory;
+    QDir().mkpath(directory);
+}
+
+bool MainWindow::LoadPositionStats(const QString& path)
+{
+    mHasStats = mStats.Load(path.toStdString());
+    return mHasStats;
+}
+
+SearchCache* MainWindow::GetSearchCache(int gridSize)
+{
+    auto& cache = mCaches[gridSize];
+    if (!cache)
+    {
+        cache.reset(new SearchCache(gridSize, Game::EngineVersion));
+        if (!mCacheDirectory.isEmpty())
+            cache->Load(GetCachePath(gridSize).toStdString());
+    }
+
+    return cache.get();
+}
+
+QString MainWindow::GetCachePath(int gridSize) const
+{
+    return QDir(mCacheDirectory).filePath(QString("cache-%1.bin").arg(gridSize));
+}
+
 void MainWindow::on_actionAbout_triggered()
 {
     QMessageBox::about(this, tr("TicTacToe"), tr("TicTacToe About us..."));
@@ -54,7 +108,11 @@ void MainWindow::SetStatus(Status status)
 
 void MainWindow::GoToOptions()
 {
-    mWorker.requestInterruption();
+    mCpu.Cancel();
+    mEngine.Cancel();
+    StopAnalysis();
+    ui->actionUndo->setEnabled(false);
+    ui->actionRedo->setEnabled(false);
     SetStatus(SetOptions);
     ui->stackedWidget->setCurrentIndex(OptionsIndex);
 }
@@ -62,46 +120,114 @@ void MainWindow::GoToOptions()
 void MainWindow::GoToGame()
 {
     int gridSize = ui->pbGridSize->text().toInt();
-    mGame = Game(ui->cbEasyMode->isChecked(), ui->cbCpuFirst->isChecked(), gridSize);
+    mGame = Game(static_cast<Game::Level>(ui->cbLevel->currentIndex()), ui->cbCpuFirst->isChecked(), gridSize);
+    mGame.SetSearchCache(GetSearchCache(gridSize));
+    if (mHasStats)
+        mGame.SetPositionStats(&mStats);
+    mMoveList.clear();
 
-    if (mButtons.size() != (gridSize * gridSize))
-    {
-        for (auto& button : mButtons)
-            delete button;
+    mBoard->SetGridSize(gridSize);
+    ProcessMove(Game::Position(), Game::UiSign::None);
 
-        mButtons.clear();
-        mButtons.reserve(gridSize * gridSize);
+    ui->stackedWidget->setCurrentIndex(GameIndex);
+}
 
-        for (int i = 0; i != gridSize; i++)
-        {
-            for (int j = 0; j != gridSize; j++)
-            {
-                QPushButton* pb = new QPushButton(this);
-
-                QFont f = pb->font();
-                f.setPointSize(20);
-
-                pb->setFont(f);
-                pb->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-                pb->setProperty(sXPos, i);
-                pb->setProperty(sYPos, j);
-                pb->setText(" ");
-
-                ui->glGame->addWidget(pb, i, j);
-                mButtons.push_back(pb);
-                connect(pb, &QPushButton::clicked, this, &MainWindow::PlayerClicked);
-            }
-        }
+void MainWindow::on_actionMove_Now_triggered()
+{
+    mCpu.MoveNow();
+    mEngine.MoveNow();
+}
+
+void MainWindow::on_actionUndo_triggered()
+{
+    if (ui->stackedWidget->currentIndex() != GameIndex || !mGame.CanUndo())
+        return;
+
+    // a search for the position being taken back is of no use anymore
+    mCpu.Cancel();
+    mEngine.Cancel();
+
+    // back to the last position with the user to move, the CPU answers it again otherwise
+    int undone = 0;
+    do
+    {
+        UndoMove();
+        undone++;
     }
-    else
+    while (mGame.GetPlayerAtMove() != Game::PlayerEntity::User && mGame.CanUndo());
+
+    // only the opening move of the CPU is left, keep it
+    if (mGame.GetPlayerAtMove() != Game::PlayerEntity::User)
+        while (undone-- > 0)
+            RedoMove();
+
+    ProcessMove(Game::Position(), Game::UiSign::None);
+}
+
+void MainWindow::on_actionRedo_triggered()
+{
+    if (ui->stackedWidget->currentIndex() != GameIndex || !mGame.CanRedo() || IsCpuBusy())
+        return;
+
+    do
     {
-        for (auto& button : mButtons)
-            button->setText(" ");
+        RedoMove();
     }
+    while (mGame.GetPlayerAtMove() == Game::PlayerEntity::Cpu && mGame.CanRedo());
 
-    ProcessButton(nullptr, Game::UiSign::None);
+    ProcessMove(Game::Position(), Game::UiSign::None);
+}
 
-    ui->stackedWidget->setCurrentIndex(GameIndex);
+void MainWindow::UndoMove()
+{
+    mBoard->SetMark(mGame.UndoMove(), Game::UiSign::None);
+    mMoveList.removeLast();
+}
+
+void MainWindow::RedoMove()
+{
+    Game::Position p = mGame.RedoMove();
+    mBoard->SetMark(p, mGame.GetUiSign(p));
+    mMoveList.append(QString::fromStdString(Game::PositionToString(p)));
+}
+
+void MainWindow::UpdateUndoActions()
+{
+    ui->actionUndo->setEnabled(mGame.CanUndo());
+    ui->actionRedo->setEnabled(mGame.CanRedo());
+}
+
+void MainWindow::on_actionAnalysis_toggled(bool checked)
+{
+    if (checked)
+        StartAnalysis();
+    else
+        StopAnalysis();
+}
+
+void MainWindow::StartAnalysis()
+{
+    if (!ui->actionAnalysis->isChecked() || ui->stackedWidget->currentIndex() != GameIndex ||
+        mGame.GetPlayerAtMove() != Game::PlayerEntity::User)
+        return;
+
+    // the shared cache keeps whatever was solved for earlier positions
+    Game game = mGame;
+    game.SetSearchCache(GetSearchCache(mGame.GetGridSize()));
+    mAnalyzer.Start(game);
+}
+
+void MainWindow::StopAnalysis()
+{
+    mAnalyzer.Stop();
+    mBoard->ClearHeat();
+}
+
+void MainWindow::AnalysisUpdated(const std::vector<Game::CellAnalysis>& cells, int depth)
+{
+    TRACE_INSTANT("MainWindow::AnalysisUpdated");
+    mBoard->SetHeat(cells);
+    ui->statusbar->showMessage(tr("Your move, click a tile (analysis depth %1)").arg(depth));
 }
 
 void MainWindow::on_psStart_clicked()
@@ -109,17 +235,15 @@ void MainWindow::on_psStart_clicked()
     GoToGame();
 }
 
-void MainWindow::ProcessButton(QPushButton* pb, Game::UiSign sign)
+void MainWindow::ProcessMove(Game::Position p, Game::UiSign sign)
 {
-    if (pb)
-    {
-        switch (sign)
-        {
-        case Game::UiSign::None: pb->setText(" "); break;
-        case Game::UiSign::X: pb->setText("X"); break;
-        case Game::UiSign::O: pb->setText("O"); break;
-        }
-    }
+    TRACE_SCOPE("MainWindow::ProcessMove");
+    if (p.mX != -1)
+        mBoard->SetMark(p, sign);
+
+    mBoard->SetCandidate(Game::Position());
+    UpdateUndoActions();
+    StopAnalysis();
 
     switch (mGame.GetPlayerAtMove())
     {
@@ -133,7 +257,10 @@ void MainWindow::ProcessButton(QPushButton* pb, Game::UiSign sign)
         }
         break;
     }
-    case Game::PlayerEntity::User: SetStatus(UserMove); break;
+    case Game::PlayerEntity::User:
+        SetStatus(UserMove);
+        StartAnalysis();
+        break;
     case Game::PlayerEntity::Cpu:
         SetStatus(CpuMove);
         QTimer::singleShot(1, this, &MainWindow::ExecuteCpuMove); // 1ms delay to process status message
@@ -141,18 +268,19 @@ void MainWindow::ProcessButton(QPushButton* pb, Game::UiSign sign)
     }
 }
 
-void MainWindow::PlayerClicked()
+void MainWindow::PlayerClicked(int posX, int posY)
 {
+    TRACE_SCOPE("MainWindow::PlayerClicked");
     QMutexLocker locker(&mUserMutex); //for very fast mouse clicks
 
-    if (!mWorker.isRunning())
+    if (!IsCpuBusy())
     {
-        QPushButton* pb = qobject_cast<QPushButton*>(QObject::sender());
-        Game::Position p{pb->property(sXPos).toInt(), pb->property(sYPos).toInt()};
+        Game::Position p{posX, posY};
         if (mGame.UserCanMove(p))
         {
             mGame.SetMove(p);
-            ProcessButton(pb, mGame.GetUiSign(p));
+            mMoveList.append(QString::fromStdString(Game::PositionToString(p)));
+            ProcessMove(p, mGame.GetUiSign(p));
         }
         else if (mGame.GetPlayerAtMove() == Game::PlayerEntity::None)
         {
@@ -161,13 +289,48 @@ void MainWindow::PlayerClicked()
     }
 }
 
+bool MainWindow::IsCpuBusy() const
+{
+    return mCpu.IsRunning() || mEngine.IsSearching();
+}
+
 void MainWindow::ExecuteCpuMove()
 {
-    mWorker.start();
+    TRACE_SCOPE("MainWindow::ExecuteCpuMove");
+    if (mEngine.IsStarted())
+        mEngine.Search(mGame.GetGridSize(), mGame.GetLevel(), mMoveList, Game::CpuTimePerMoveMs);
+    else
+        mCpu.Start(mGame);
+}
+
+void MainWindow::CpuProgress(int posX, int posY, int score, int depth, qint64 nodes)
+{
+    if (mGame.GetPlayerAtMove() != Game::PlayerEntity::Cpu)
+        return;
+
+    TRACE_INSTANT("MainWindow::CpuProgress");
+    mBoard->SetCandidate({posX, posY});
+    ui->statusbar->showMessage(tr("CPU thinking.. depth %1, %2 nodes, score %3").arg(depth).arg(nodes).arg(score));
 }
 
-void MainWindow::CpuResultReady(int posx, int posY, int uiSign)
+void MainWindow::EngineFailed(const QString& reason)
 {
-    ProcessButton(mButtons[posx * mGame.GetGridSize() + posY], static_cast<Game::UiSign>(uiSign));
+    QMessageBox::warning(this, tr("TicTacToe"), tr("The engine stopped: %1\nThe built-in engine plays from now on.").arg(reason));
+
+    // the move the engine owed is searched again
+    if (ui->stackedWidget->currentIndex() == GameIndex && mGame.GetPlayerAtMove() == Game::PlayerEntity::Cpu &&
+            !IsCpuBusy())
+        ExecuteCpuMove();
 }
 
+void MainWindow::CpuMoveReady(int posX, int posY)
+{
+    TRACE_SCOPE("MainWindow::CpuMoveReady");
+    Game::Position p{posX, posY};
+    if (mGame.GetPlayerAtMove() != Game::PlayerEntity::Cpu)
+        return;
+
+    mGame.SetMove(p);
+    mMoveList.append(QString::fromStdString(Game::PositionToString(p)));
+    ProcessMove(p, mGame.GetUiSign(p));
+}
@@ -2,37 +2,21 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QThread>
 #include <QMutexLocker>
+#include <map>
+#include <memory>
 #include "game.h"
+#include "analyzer.h"
+#include "asyncengine.h"
+#include "engineprocess.h"
+#include "positionstats.h"
+#include "searchcache.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-class GameThread : public QThread
-{
-    Q_OBJECT
-public:
-    GameThread(Game& game) : QThread(), mGame(game) {}
-private:
-    void run() override
-    {
-        Game::Position pos;
-        Game::UiSign uiSign = Game::UiSign::None;
-        mGame.ExecuteCpuMove(pos, uiSign);
-        if (!isInterruptionRequested())
-        {
-            emit CpuResultReady(pos.mX, pos.mY, static_cast<int>(uiSign));
-        }
-    }
-signals:
-    void CpuResultReady(int posx, int posY, int uiSign);
-private:
-    Game& mGame;
-};
-
-class QPushButton;
+class BoardWidget;
 
 class MainWindow : public QMainWindow
 {
@@ -59,26 +43,52 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    bool UseExternalEngine(const QString& program);
+    void SetCacheDirectory(const QString& directory);
+    bool LoadPositionStats(const QString& path);
+
 private slots:
     void on_actionAbout_triggered();
     void on_actionExit_triggered();
     void on_actionNew_Game_triggered();
+    void on_actionMove_Now_triggered();
+    void on_actionUndo_triggered();
+    void on_actionRedo_triggered();
+    void on_actionAnalysis_toggled(bool checked);
     void on_psStart_clicked();
 
     void ExecuteCpuMove();
-    void CpuResultReady(int posx, int posY, int uiSign);
+    void CpuProgress(int posX, int posY, int score, int depth, qint64 nodes);
+    void CpuMoveReady(int posX, int posY);
+    void EngineFailed(const QString& reason);
+    void AnalysisUpdated(const std::vector<Game::CellAnalysis>& cells, int depth);
 
 private:
     void GoToOptions();
     void GoToGame();
-    void PlayerClicked();
+    void PlayerClicked(int posX, int posY);
     void SetStatus(Status status);
-    void ProcessButton(QPushButton* pb, Game::UiSign sign);
+    void ProcessMove(Game::Position p, Game::UiSign sign);
+    bool IsCpuBusy() const;
+    void UndoMove();
+    void RedoMove();
+    void UpdateUndoActions();
+    void StartAnalysis();
+    void StopAnalysis();
+    SearchCache* GetSearchCache(int gridSize);
+    QString GetCachePath(int gridSize) const;
 
 private:
     Ui::MainWindow *ui;
-    QList<QPushButton*> mButtons;
-    GameThread mWorker;
+    BoardWidget* mBoard;
+    AsyncEngine mCpu;
+    Analyzer mAnalyzer;
+    EngineProcess mEngine;
+    QStringList mMoveList;
+    QString mCacheDirectory;
+    std::map<int, std::unique_ptr<SearchCache>> mCaches;
+    PositionStats mStats;
+    bool mHasStats = false;
     QMutex mUserMutex;
     Game mGame;
 
@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -8,13 +8,21 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(../core/core.pri)
+
 SOURCES += \
-    game.cpp \
+    analyzer.cpp \
+    asyncengine.cpp \
+    boardwidget.cpp \
+    engineprocess.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
-    game.h \
+    analyzer.h \
+    asyncengine.h \
+    boardwidget.h \
+    engineprocess.h \
     mainwindow.h
 
 FORMS += \
@@ -0,0 +1,432 @@
+// Plays two engine configurations against each other on every core and reports
+// the Elo difference, optionally stopping early on a sequential probability
+// ratio test.
+//
+//  tictactoe-tournament [--a <config>] [--b <config>] [--games <n>]
+//                       [--sizes <n,n,...>] [--opening-plies <n>] [--seed <s>]
+//                       [--threads <n>] [--sprt <elo0> <elo1>] [--alpha <a>]
+//                       [--beta <b>] [--output <file>] [--report <n>]
+//
+// A config holds the search settings of an engine (core/engineconfig.h), e.g.
+// "level=4,nodes=20000,proof=0". Its search cache is shared by all games of
+// that engine on one grid size.
+//
+// Games come in pairs: both play the same random opening of --opening-plies
+// moves on the same grid size, with each engine moving first once. The sizes
+// are used in turn, 3 to 8 by default.
+//
+// Every finished game is appended to --output at once as
+//  game <i> size <n> opening <moves> first <A|B> result <1-0|1/2-1/2|0-1> moves <moves>
+// from the point of view of engine A, and a summary line goes to stdout every
+// --report games and at the end. With --sprt the run stops as soon as the log
+// likelihood ratio of elo1 against elo0 leaves the bounds set by alpha and beta.
+
+#include "engineconfig.h"
+#include "game.h"
+#include "patterneval.h"
+#include "positionstats.h"
+#include "random.h"
+#include "searchcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+enum
+{
+    DefaultGames = 1000,
+    DefaultOpeningPlies = 2,
+    DefaultReport = 100,
+};
+
+struct Options
+{
+    EngineConfig mEngines[2];
+    int mGames = DefaultGames;
+    std::vector<int> mSizes;
+    int mOpeningPlies = DefaultOpeningPlies;
+    uint32_t mSeed = 1;
+    int mThreads = 0;
+    bool mSprt = false;
+    double mElo0 = 0.0;
+    double mElo1 = 5.0;
+    double mAlpha = 0.05;
+    double mBeta = 0.05;
+    std::string mOutput;
+    int mReport = DefaultReport;
+};
+
+struct Standing
+{
+    int mWins = 0;
+    int mDraws = 0;
+    int mLosses = 0;
+
+    int GetGames() const {return mWins + mDraws + mLosses;}
+    double GetScore() const {return (mWins + 0.5 * mDraws) / GetGames();}
+    // of a single game score around the mean
+    double GetVariance() const
+    {
+        double score = GetScore();
+        return (mWins * (1.0 - score) * (1.0 - score) + mDraws * (0.5 - score) * (0.5 - score) +
+                mLosses * score * score) / GetGames();
+    }
+};
+
+static bool ParseSizes(const std::string& text, std::vector<int>& sizes)
+{
+    sizes.clear();
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        int size = std::atoi(item.c_str());
+        if (!Geometry::IsSupported(size))
+            return false;
+        sizes.push_back(size);
+    }
+
+    return !sizes.empty();
+}
+
+// expected score of the stronger side for an Elo difference and back
+static double EloToScore(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+static double ScoreToElo(double score)
+{
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+class Tournament
+{
+public:
+    explicit Tournament(const Options& options)
+        : mOptions(options)
+        , mNextGame(0)
+        , mStop(false)
+    {
+        for (int engine = 0; engine < 2; engine++)
+            for (int size : mOptions.mSizes)
+                if (!mCaches[engine][size])
+                    mCaches[engine][size].reset(new SearchCache(size, Game::EngineVersion,
+                                                                mOptions.mEngines[engine].mCacheMegabytes));
+    }
+
+    bool LoadFiles()
+    {
+        for (int engine = 0; engine < 2; engine++)
+        {
+            const EngineConfig& config = mOptions.mEngines[engine];
+            if (!config.mStatsPath.empty())
+            {
+                mStats[engine].reset(new PositionStats());
+                if (!mStats[engine]->Load(config.mStatsPath))
+                {
+                    std::cerr << "cannot load " << config.mStatsPath << std::endl;
+                    return false;
+                }
+            }
+
+            if (!config.mEvalPath.empty())
+            {
+                mEvals[engine].reset(new PatternEval());
+                if (!mEvals[engine]->Load(config.mEvalPath))
+                {
+                    std::cerr << "cannot load " << config.mEvalPath << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool Run()
+    {
+        if (!LoadFiles())
+            return false;
+
+        if (!mOptions.mOutput.empty())
+        {
+            mOutput.open(mOptions.mOutput, std::ios::app);
+            if (!mOutput)
+            {
+                std::cerr << "cannot write " << mOptions.mOutput << std::endl;
+                return false;
+            }
+        }
+
+        int threads = mOptions.mThreads > 0 ? mOptions.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back(&Tournament::WorkerLoop, this);
+        for (auto& worker : workers)
+            worker.join();
+
+        // the last report may already have printed the final standing
+        if (mOptions.mReport == 0 || mStanding.GetGames() % mOptions.mReport != 0)
+            PrintSummary();
+        if (mOptions.mSprt)
+            std::cout << "sprt " << (mVerdict.empty() ? "inconclusive" : mVerdict) << std::endl;
+        return true;
+    }
+
+private:
+    struct Record
+    {
+        int mIndex = 0;
+        int mGridSize = 3;
+        bool mIsAFirst = true;
+        int mOpeningPlies = 0;
+        std::vector<Game::Position> mMoves;
+        Game::PlayerEntity mWinner = Game::PlayerEntity::None;  // Cpu is engine A
+    };
+
+    void WorkerLoop()
+    {
+        for (;;)
+        {
+            int index = mNextGame++;
+            if (index >= mOptions.mGames || mStop)
+                return;
+
+            Record record = PlayGame(index);
+            Report(record);
+        }
+    }
+
+    Record PlayGame(int index)
+    {
+        // both games of a pair share size and opening, only the side moving first differs
+        int pair = index / 2;
+        Record record;
+        record.mIndex = index;
+        record.mGridSize = mOptions.mSizes[pair % mOptions.mSizes.size()];
+        record.mIsAFirst = index % 2 == 0;
+
+        // engine A plays as the CPU of one game and engine B as the CPU of the other
+        Game games[2] =
+        {
+            MakeGame(0, record.mGridSize, record.mIsAFirst, index),
+            MakeGame(1, record.mGridSize, !record.mIsAFirst, index),
+        };
+
+        Random random(static_cast<uint64_t>(mOptions.mSeed) << 32 | static_cast<uint32_t>(pair));
+        int cells = record.mGridSize * record.mGridSize;
+        for (int ply = 0; ply < mOptions.mOpeningPlies && ply < cells - 1; ply++)
+        {
+            std::vector<Game::Position> empty;
+            for (int cell = 0; cell < cells; cell++)
+            {
+                Game::Position p(cell / record.mGridSize, cell % record.mGridSize);
+                if (games[0].GetCell(p) == Game::PlayerEntity::None)
+                    empty.push_back(p);
+            }
+
+            Game::Position p = empty[Random::Bounded(random.Generate(), (int)empty.size())];
+            Play(games, p, record);
+            if (games[0].GetPlayerAtMove() == Game::PlayerEntity::None)
+                break;
+        }
+        record.mOpeningPlies = (int)record.mMoves.size();
+
+        while (games[0].GetPlayerAtMove() != Game::PlayerEntity::None && !mStop)
+        {
+            Game& mover = games[0].GetPlayerAtMove() == Game::PlayerEntity::Cpu ? games[0] : games[1];
+            Play(games, mover.FindCpuMove(), record);
+        }
+
+        record.mWinner = games[0].GetWinner();
+        return record;
+    }
+
+    Game MakeGame(int engine, int gridSize, bool isCpuFirst, int index)
+    {
+        Game game = mOptions.mEngines[engine].MakeGame(isCpuFirst, gridSize);
+        game.SetSeed(mOptions.mSeed + 2 * index + engine);
+        game.SetSearchCache(mCaches[engine][gridSize].get());
+        game.SetPositionStats(mStats[engine].get());
+        game.SetPatternEval(mEvals[engine].get());
+        return game;
+    }
+
+    static void Play(Game* games, Game::Position p, Record& record)
+    {
+        games[0].SetMove(p);
+        games[1].SetMove(p);
+        record.mMoves.push_back(p);
+    }
+
+    void Report(const Record& record)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // a game cut short by the stop is not counted
+        if (mStop)
+            return;
+
+        const char* result = "1/2-1/2";
+        switch (record.mWinner)
+        {
+        case Game::PlayerEntity::Cpu: mStanding.mWins++; result = "1-0"; break;
+        case Game::PlayerEntity::User: mStanding.mLosses++; result = "0-1"; break;
+        case Game::PlayerEntity::None: mStanding.mDraws++; break;
+        }
+
+        if (mOutput.is_open())
+        {
+            mOutput << "game " << record.mIndex << " size " << record.mGridSize
+                    << " opening " << FormatMoves(record.mMoves, 0, record.mOpeningPlies)
+                    << " first " << (record.mIsAFirst ? 'A' : 'B') << " result " << result
+                    << " moves " << FormatMoves(record.mMoves, record.mOpeningPlies, (int)record.mMoves.size())
+                    << std::endl;
+        }
+
+        if (mOptions.mReport > 0 && mStanding.GetGames() % mOptions.mReport == 0)
+            PrintSummary();
+
+        if (mOptions.mSprt)
+        {
+            double llr = GetLogLikelihoodRatio();
+            if (llr >= std::log((1.0 - mOptions.mBeta) / mOptions.mAlpha))
+                mVerdict = "H1 accepted";
+            else if (llr <= std::log(mOptions.mBeta / (1.0 - mOptions.mAlpha)))
+                mVerdict = "H0 accepted";
+
+            if (!mVerdict.empty())
+                mStop = true;
+        }
+    }
+
+    // normal approximation of the generalized SPRT on the per game scores,
+    // elo0 and elo1 are the Elo differences of the two hypotheses
+    double GetLogLikelihoodRatio() const
+    {
+        int games = mStanding.GetGames();
+        double score = mStanding.GetScore();
+        double variance = mStanding.GetVariance();
+
+        // only draws so far say nothing about either hypothesis
+        if (variance <= 0.0)
+            return 0.0;
+
+        double score0 = EloToScore(mOptions.mElo0);
+        double score1 = EloToScore(mOptions.mElo1);
+        return 0.5 * games * ((score - score0) * (score - score0) - (score - score1) * (score - score1)) / variance;
+    }
+
+    void PrintSummary() const
+    {
+        int games = mStanding.GetGames();
+        if (games == 0)
+            return;
+
+        // 95% interval of the mean score, mapped to Elo; all wins or losses are clamped
+        double score = mStanding.GetScore();
+        double margin = 1.96 * std::sqrt(mStanding.GetVariance() / games);
+        double bound = 0.5 / games;
+        auto elo = [bound](double s) {return ScoreToElo(std::max(bound, std::min(1.0 - bound, s)));};
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "games %d +%d =%d -%d score %.1f%% elo %+.1f [%+.1f, %+.1f]",
+                      games, mStanding.mWins, mStanding.mDraws, mStanding.mLosses, 100.0 * score,
+                      elo(score), elo(score - margin), elo(score + margin));
+        std::cout << line;
+        if (mOptions.mSprt)
+        {
+            std::snprintf(line, sizeof(line), " llr %.2f (%.2f, %.2f)", GetLogLikelihoodRatio(),
+                          std::log(mOptions.mBeta / (1.0 - mOptions.mAlpha)), std::log((1.0 - mOptions.mBeta) / mOptions.mAlpha));
+            std::cout << line;
+        }
+        std::cout << std::endl;
+    }
+
+    static std::string FormatMoves(const std::vector<Game::Position>& moves, int begin, int end)
+    {
+        if (begin == end)
+            return "-";
+
+        std::string text;
+        for (int i = begin; i < end; i++)
+            text += (i == begin ? "" : ",") + Game::PositionToString(moves[i]);
+        return text;
+    }
+
+private:
+    const Options& mOptions;
+    std::map<int, std::unique_ptr<SearchCache>> mCaches[2];
+    std::unique_ptr<PositionStats> mStats[2];
+    std::unique_ptr<PatternEval> mEvals[2];
+    std::atomic_int mNextGame;
+    std::atomic_bool mStop;
+
+    std::mutex mMutex;
+    Standing mStanding;
+    std::string mVerdict;
+    std::ofstream mOutput;
+};
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int n = Geometry::MinGridSize; n <= Geometry::MaxGridSize; n++)
+        options.mSizes.push_back(n);
+
+    bool isValid = true;
+    for (int i = 1; i < argc && isValid; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--a" || arg == "--b") && i + 1 < argc)
+            isValid = options.mEngines[arg == "--a" ? 0 : 1].Parse(argv[++i]);
+        else if (arg == "--games" && i + 1 < argc)
+            options.mGames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sizes" && i + 1 < argc)
+            isValid = ParseSizes(argv[++i], options.mSizes);
+        else if (arg == "--opening-plies" && i + 1 < argc)
+            options.mOpeningPlies = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            options.mSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && i + 1 < argc)
+            options.mThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sprt" && i + 2 < argc)
+        {
+            options.mSprt = true;
+            options.mElo0 = std::atof(argv[++i]);
+            options.mElo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && i + 1 < argc)
+            options.mAlpha = std::atof(argv[++i]);
+        else if (arg == "--beta" && i + 1 < argc)
+            options.mBeta = std::atof(argv[++i]);
+        else if (arg == "--output" && i + 1 < argc)
+            options.mOutput = argv[++i];
+        else if (arg == "--report" && i + 1 < argc)
+            options.mReport = std::max(0, std::atoi(argv[++i]));
+        else
+            isValid = false;
+    }
+
+    if (!isValid || options.mAlpha <= 0.0 || options.mAlpha >= 1.0 || options.mBeta <= 0.0 || options.mBeta >= 1.0)
+    {
+        std::cerr << "usage: tictactoe-tournament [--a <config>] [--b <config>] [--games <n>] [--sizes <n,n,...>]\n"
+                     "                            [--opening-plies <n>] [--seed <s>] [--threads <n>]\n"
+                     "                            [--sprt <elo0> <elo1>] [--alpha <a>] [--beta <b>]\n"
+                     "                            [--output <file>] [--report <n>]\n"
+                     "config: " << EngineConfig::GetUsage() << std::endl;
+        return 2;
+    }
+
+    Tournament tournament(options);
+    return tournament.Run() ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+// Trains the pattern evaluation (core/patterneval.h) on the positions written
+// by tictactoe-selfplay.
+//
+//  tictactoe-train --output <weights> [--weights <file>] [--epochs <n>]
+//                  [--rate <r>] [--holdout <fraction>] [--seed <s>] <data ...>
+//
+// The value of each position is fitted to the final result of its game by
+// stochastic gradient descent on the squared error, positions the search had
+// already proven won or lost are fitted to that instead. Every grid size found
+// in the data gets its own weights, starting from zero or from --weights. A
+// --holdout fraction (0.1 by default) of the positions is kept out of training
+// and its error printed after every epoch next to the training error.
+
+#include "game.h"
+#include "patterneval.h"
+#include "positioncode.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+enum
+{
+    FormatVersion = 1,
+    DefaultEpochs = 10,
+};
+
+static const char sMagic[4] = {'T', 'T', 'T', 'D'};
+
+struct Sample
+{
+    uint8_t mGridSize;
+    int8_t mTarget;
+    int32_t mIndexes[PatternEval::MaxTuples];
+};
+
+static bool ReadData(const std::string& path, std::vector<Sample>& samples)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 8 || std::memcmp(data.data(), sMagic, sizeof(sMagic)) != 0 ||
+            (data[4] | data[5] << 8 | data[6] << 16 | uint32_t(data[7]) << 24) != FormatVersion)
+        return false;
+
+    // a record is the binary code, the int16 search score and the int8 result
+    size_t offset = 8;
+    while (offset < data.size())
+    {
+        if (!Geometry::IsSupported(data[offset]))
+            return false;
+
+        int codeSize = 2 + (data[offset] * data[offset] + 3) / 4;
+        if (offset + codeSize + 3 > data.size())
+            return false;
+
+        PositionCode code;
+        if (!code.ReadBinary(&data[offset], codeSize))
+            return false;
+
+        const uint8_t* label = &data[offset + codeSize];
+        int score = static_cast<int16_t>(label[0] | label[1] << 8);
+        int result = static_cast<int8_t>(label[2]);
+        offset += codeSize + 3;
+
+        // a proven score is closer to the truth than the result of one game
+        Sample sample;
+        sample.mGridSize = code.mGridSize;
+        sample.mTarget = static_cast<int8_t>(result);
+        if (std::abs(score) > Game::CpuWin - Geometry::MaxCells)
+            sample.mTarget = score > 0 ? 1 : -1;
+        PatternEval::GetIndexes(code, sample.mIndexes);
+        samples.push_back(sample);
+    }
+
+    return true;
+}
+
+// the squared error of the sample before the step, a rate of 0 only measures it
+static double Step(PatternEval& eval, const Sample& sample, float rate)
+{
+    const PatternEval::Layout& layout = PatternEval::GetLayout(sample.mGridSize);
+    float* weights = eval.GetWeights(sample.mGridSize);
+    float value = PatternEval::ToValue(PatternEval::Sum(weights, sample.mIndexes, layout.mTupleCount));
+    float error = value - sample.mTarget;
+    if (rate > 0.0f)
+    {
+        // the derivative of tanh, shared out over the tuples
+        float step = rate * error * (1.0f - value * value) / layout.mTupleCount;
+        for (int t = 0; t < layout.mTupleCount; t++)
+            weights[sample.mIndexes[t]] -= step;
+    }
+
+    return double(error) * error;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output;
+    std::string initial;
+    std::vector<std::string> inputs;
+    int epochs = DefaultEpochs;
+    float rate = 1.0f;
+    double holdout = 0.1;
+    uint32_t seed = 1;
+
+    bool isValid = true;
+    for (int i = 1; i < argc && isValid; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "--weights" && i + 1 < argc)
+            initial = argv[++i];
+        else if (arg == "--epochs" && i + 1 < argc)
+            epochs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rate" && i + 1 < argc)
+            rate = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--holdout" && i + 1 < argc)
+            holdout = std::max(0.0, std::min(0.9, std::atof(argv[++i])));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg.compare(0, 2, "--") != 0)
+            inputs.push_back(arg);
+        else
+            isValid = false;
+    }
+
+    if (!isValid || output.empty() || inputs.empty() || rate <= 0.0f)
+    {
+        std::cerr << "usage: tictactoe-train --output <weights> [--weights <file>] [--epochs <n>]\n"
+                     "                       [--rate <r>] [--holdout <fraction>] [--seed <s>] <data ...>" << std::endl;
+        return 2;
+    }
+
+    std::vector<Sample> samples;
+    for (const std::string& input : inputs)
+    {
+        if (!ReadData(input, samples))
+        {
+            std::cerr << "cannot read " << input << std::endl;
+            return 1;
+        }
+    }
+
+    PatternEval eval;
+    if (!initial.empty() && !eval.Load(initial))
+    {
+        std::cerr << "cannot load " << initial << std::endl;
+        return 1;
+    }
+
+    for (const Sample& sample : samples)
+        if (!eval.HasWeights(sample.mGridSize))
+            eval.ResetWeights(sample.mGridSize);
+
+    // the holdout positions are drawn once, the training order anew every epoch
+    Random random(seed);
+    std::vector<size_t> order(samples.size());
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t k = order.size(); k > 1; k--)
+        std::swap(order[k - 1], order[Random::Bounded(random.Generate(), (int)k)]);
+
+    size_t holdoutCount = static_cast<size_t>(holdout * samples.size());
+    std::vector<size_t> held(order.begin(), order.begin() + holdoutCount);
+    order.erase(order.begin(), order.begin() + holdoutCount);
+
+    std::cout << samples.size() << " positions, " << order.size() << " for training, " << held.size() << " held out"
+              << std::endl;
+    for (int epoch = 1; epoch <= epochs && !order.empty(); epoch++)
+    {
+        for (size_t k = order.size(); k > 1; k--)
+            std::swap(order[k - 1], order[Random::Bounded(random.Generate(), (int)k)]);
+
+        double trainError = 0.0;
+        for (size_t index : order)
+            trainError += Step(eval, samples[index], rate);
+
+        double heldError = 0.0;
+        for (size_t index : held)
+            heldError += Step(eval, samples[index], 0.0f);
+
+        std::cout << "epoch " << epoch << " train " << trainError / order.size();
+        if (!held.empty())
+            std::cout << " holdout " << heldError / held.size();
+        std::cout << std::endl;
+    }
+
+    if (!eval.Save(output))
+    {
+        std::cerr << "cannot write " << output << std::endl;
+        return 1;
+    }
+
+    return 0;
+}